@@ -234,8 +234,291 @@ static void load_settings(neuralnet::trainer_settings_t& settings) {
     }
 }
 
+#ifdef NN_SUPPORT_cpu
+static size_t find_prediction(const std::vector<number_t>& outputs) {
+    return (size_t)(std::max_element(outputs.begin(), outputs.end()) - outputs.begin());
+}
+
+// quantizes the saved network to int8 and compares it with full precision on the testing set
+static int quantize_network(const mnist_dataset& dataset) {
+    ZoneScoped;
+
+    neuralnet::loader loader(neuralnet::fs::current_path() / "network");
+    if (!loader.load_from_file()) {
+        std::cerr << "no saved network to quantize!" << std::endl;
+        return 1;
+    }
+
+    static constexpr uint64_t calibration_samples = 1000;
+    auto network = neuralnet::unique(loader.release_network());
+    auto quantized = neuralnet::unique(neuralnet::quantized_network::quantize(
+        network.get(), &dataset, neuralnet::dataset_group::training, calibration_samples));
+
+    neuralnet::evaluators::cpu_evaluator evaluator;
+    neuralnet::evaluators::cpu_workspace_t workspace;
+    workspace.reserve(network.get());
+    workspace.reserve(quantized.get());
+
+    auto group = neuralnet::dataset_group::testing;
+    uint64_t sample_count = dataset.get_sample_count(group);
+
+    std::vector<number_t> inputs, expected, outputs(mnist_dataset::output_count),
+        quantized_outputs(mnist_dataset::output_count);
+
+    uint64_t correct = 0, quantized_correct = 0;
+    number_t max_error = 0;
+    std::chrono::duration<double> float_time(0), quantized_time(0);
+
+    for (uint64_t i = 0; i < sample_count; i++) {
+        dataset.get_sample(group, i, inputs, expected);
+
+        auto start = std::chrono::steady_clock::now();
+        evaluator.infer(network.get(), inputs, outputs, workspace);
+
+        auto middle = std::chrono::steady_clock::now();
+        evaluator.infer(quantized.get(), inputs, quantized_outputs, workspace);
+
+        auto end = std::chrono::steady_clock::now();
+        float_time += middle - start;
+        quantized_time += end - middle;
+
+        size_t label = find_prediction(expected);
+        correct += find_prediction(outputs) == label ? 1 : 0;
+        quantized_correct += find_prediction(quantized_outputs) == label ? 1 : 0;
+
+        for (size_t j = 0; j < outputs.size(); j++) {
+            max_error = std::max(max_error, std::abs(outputs[j] - quantized_outputs[j]));
+        }
+    }
+
+    size_t float_size = 0;
+    for (const auto& layer : network->get_layers()) {
+        float_size += (layer.weights.size() + layer.biases.size()) * sizeof(number_t);
+    }
+
+    double accuracy = (double)correct / sample_count;
+    double quantized_accuracy = (double)quantized_correct / sample_count;
+
+    std::cout << "samples: " << sample_count << std::endl;
+    std::cout << "fp32 accuracy: " << accuracy * 100 << "%, "
+              << float_time.count() * 1e6 / sample_count << "us/sample, " << float_size
+              << " bytes" << std::endl;
+
+    std::cout << "int8 accuracy: " << quantized_accuracy * 100 << "%, "
+              << quantized_time.count() * 1e6 / sample_count << "us/sample, "
+              << quantized->get_parameter_size() << " bytes" << std::endl;
+
+    std::cout << "accuracy delta: " << (quantized_accuracy - accuracy) * 100
+              << "%, max output error: " << max_error << std::endl;
+
+    return 0;
+}
+
+// factors the saved network to a low rank and compares it with full precision on the testing set
+// amount is a rank if it is at least 1, and an energy fraction otherwise
+static int factorize_network(const mnist_dataset& dataset, double amount) {
+    ZoneScoped;
+
+    neuralnet::loader loader(neuralnet::fs::current_path() / "network");
+    if (!loader.load_from_file()) {
+        std::cerr << "no saved network to factorize!" << std::endl;
+        return 1;
+    }
+
+    neuralnet::factorization_settings_t settings;
+    settings.rank = amount >= 1 ? (uint64_t)amount : 0;
+    settings.energy = amount;
+
+    auto network = neuralnet::unique(loader.release_network());
+    auto factorized =
+        neuralnet::unique(neuralnet::factorized_network::factorize(network.get(), settings));
+
+    auto group = neuralnet::dataset_group::testing;
+    auto report = factorized->compare(network.get(), &dataset, group);
+
+    // the report evaluates both networks with plain loops; time the evaluator on its own
+    neuralnet::evaluators::cpu_evaluator evaluator;
+    neuralnet::evaluators::cpu_workspace_t workspace;
+    workspace.reserve(network.get());
+    workspace.reserve(factorized.get());
+
+    std::vector<number_t> inputs, expected, outputs(mnist_dataset::output_count);
+    std::chrono::duration<double> dense_time(0), factorized_time(0);
+
+    for (uint64_t i = 0; i < report.samples; i++) {
+        dataset.get_sample(group, i, inputs, expected);
+
+        auto start = std::chrono::steady_clock::now();
+        evaluator.infer(network.get(), inputs, outputs, workspace);
+
+        auto middle = std::chrono::steady_clock::now();
+        evaluator.infer(factorized.get(), inputs, outputs, workspace);
+
+        auto end = std::chrono::steady_clock::now();
+        dense_time += middle - start;
+        factorized_time += end - middle;
+    }
+
+    std::cout << "ranks:";
+    for (const auto& layer : factorized->get_layers()) {
+        std::cout << ' ' << (layer.rank > 0 ? std::to_string(layer.rank) : "dense");
+    }
+
+    std::cout << std::endl << "samples: " << report.samples << std::endl;
+    std::cout << "dense accuracy: " << report.dense_accuracy * 100 << "%, "
+              << report.dense_multiply_adds << " multiply-adds, "
+              << dense_time.count() * 1e6 / report.samples << "us/sample" << std::endl;
+
+    std::cout << "factorized accuracy: " << report.factorized_accuracy * 100 << "%, "
+              << report.factorized_multiply_adds << " multiply-adds, "
+              << factorized_time.count() * 1e6 / report.samples << "us/sample" << std::endl;
+
+    double saved = 1 - (double)report.factorized_multiply_adds / report.dense_multiply_adds;
+    std::cout << "multiply-adds saved: " << saved * 100 << "%, accuracy delta: "
+              << (report.factorized_accuracy - report.dense_accuracy) * 100
+              << "%, max output error: " << report.max_error << std::endl;
+
+    return 0;
+}
+
+struct batch_accuracy_t {
+    double accuracy;
+    std::chrono::duration<double> time;
+};
+
+// evaluates the testing set in batches, as training does
+static batch_accuracy_t evaluate_testing_set(neuralnet::evaluators::cpu_evaluator& evaluator,
+                                             const neuralnet::network* network,
+                                             const mnist_dataset& dataset) {
+    ZoneScoped;
+
+    static constexpr uint64_t batch_size = 100;
+    auto group = neuralnet::dataset_group::testing;
+    uint64_t sample_count = dataset.get_sample_count(group);
+
+    std::vector<number_t> inputs, expected, batch_inputs, outputs, sample_outputs;
+    std::vector<size_t> labels;
+
+    uint64_t correct = 0;
+    std::chrono::duration<double> time(0);
+
+    for (uint64_t begin = 0; begin < sample_count; begin += batch_size) {
+        uint64_t end = std::min(begin + batch_size, sample_count);
+        batch_inputs.clear();
+        labels.clear();
+
+        for (uint64_t i = begin; i < end; i++) {
+            dataset.get_sample(group, i, inputs, expected);
+            batch_inputs.insert(batch_inputs.end(), inputs.begin(), inputs.end());
+            labels.push_back(find_prediction(expected));
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        auto key = evaluator.begin_eval(network, batch_inputs);
+        evaluator.wait_idle();
+        time += std::chrono::steady_clock::now() - start;
+
+        void* native_outputs;
+        evaluator.get_eval_result(*key, &native_outputs);
+        evaluator.retrieve_eval_values(network, native_outputs, outputs);
+        evaluator.free_result(*key);
+
+        for (size_t i = 0; i < labels.size(); i++) {
+            auto sample_begin = outputs.begin() + i * mnist_dataset::output_count;
+            sample_outputs.assign(sample_begin, sample_begin + mnist_dataset::output_count);
+            correct += find_prediction(sample_outputs) == labels[i] ? 1 : 0;
+        }
+    }
+
+    return { (double)correct / sample_count, time };
+}
+
+// prunes the saved network to the given sparsity, compares it with the original on the testing
+// set and saves it to "pruned_network"
+static int prune_network(const mnist_dataset& dataset, double sparsity) {
+    ZoneScoped;
+
+    neuralnet::loader loader(neuralnet::fs::current_path() / "network");
+    if (!loader.load_from_file()) {
+        std::cerr << "no saved network to prune!" << std::endl;
+        return 1;
+    }
+
+    auto network = neuralnet::unique(loader.release_network());
+    neuralnet::evaluators::cpu_evaluator evaluator;
+
+    auto dense = evaluate_testing_set(evaluator, network.get(), dataset);
+    uint64_t pruned = neuralnet::prune_weights_to_sparsity(network.get(), sparsity);
+    evaluator.invalidate_weights(network.get());
+
+    // the same pruned network, once from its compressed weights and once from dense ones
+    auto sparse = evaluate_testing_set(evaluator, network.get(), dataset);
+    evaluator.set_sparse_weight_threshold(0);
+    auto pruned_dense = evaluate_testing_set(evaluator, network.get(), dataset);
+
+    std::cout << "pruned " << pruned << " weights" << std::endl;
+    for (const auto& layer : network->get_layers()) {
+        std::cout << "  " << layer.previous_size << " -> " << layer.size << ": "
+                  << neuralnet::get_weight_density(layer) * 100 << "% dense" << std::endl;
+    }
+
+    uint64_t sample_count = dataset.get_sample_count(neuralnet::dataset_group::testing);
+    auto report = [&](const char* name, const batch_accuracy_t& result) {
+        std::cout << name << " accuracy: " << result.accuracy * 100 << "%, "
+                  << result.time.count() * 1e6 / sample_count << "us/sample" << std::endl;
+    };
+
+    report("original", dense);
+    report("pruned (dense weights)", pruned_dense);
+    report("pruned (sparse weights)", sparse);
+
+    neuralnet::loader pruned_loader(neuralnet::fs::current_path() / "pruned_network");
+    save_network(pruned_loader, network);
+
+    return 0;
+}
+#endif
+
 int main(int argc, const char** argv) {
     ZoneScoped;
+
+    // "mnist quantize" reports how the saved network fares in int8 instead of training it
+    if (argc > 1 && std::string(argv[1]) == "quantize") {
+#ifdef NN_SUPPORT_cpu
+        mnist_dataset dataset;
+        return quantize_network(dataset);
+#else
+        std::cerr << "quantization requires the cpu evaluator!" << std::endl;
+        return 1;
+#endif
+    }
+
+    // "mnist prune [sparsity]" zeroes the smallest weights of the saved network instead
+    if (argc > 1 && std::string(argv[1]) == "prune") {
+#ifdef NN_SUPPORT_cpu
+        double sparsity = argc > 2 ? std::stod(argv[2]) : 0.8;
+
+        mnist_dataset dataset;
+        return prune_network(dataset, sparsity);
+#else
+        std::cerr << "pruning requires the cpu evaluator!" << std::endl;
+        return 1;
+#endif
+    }
+
+    // "mnist factorize [rank or energy]" factors the saved network's layers to a low rank
+    if (argc > 1 && std::string(argv[1]) == "factorize") {
+#ifdef NN_SUPPORT_cpu
+        double amount = argc > 2 ? std::stod(argv[2]) : 0.95;
+
+        mnist_dataset dataset;
+        return factorize_network(dataset, amount);
+#else
+        std::cerr << "factorization requires the cpu evaluator!" << std::endl;
+        return 1;
+#endif
+    }
+
     auto gui = std::make_unique<common::debug_gui>("mnist debug");
 
     neuralnet::trainer_settings_t settings;
@@ -258,6 +541,16 @@ int main(int argc, const char** argv) {
         return 1;
     }
 
+#ifdef NN_SUPPORT_cpu
+    if (evaluator->get_type() == neuralnet::evaluator_type::cpu) {
+        auto cpu_evaluator = (neuralnet::evaluators::cpu_evaluator*)evaluator.get();
+        auto isa = cpu_evaluator->get_kernels().isa;
+
+        std::cout << "using " << neuralnet::evaluators::get_cpu_isa_name(isa) << " cpu kernels"
+                  << std::endl;
+    }
+#endif
+
     std::unique_ptr<neuralnet::network> network;
     neuralnet::loader loader(neuralnet::fs::current_path() / "network");
 
@@ -266,11 +559,17 @@ int main(int argc, const char** argv) {
         network = neuralnet::unique(loader.release_network());
     } else {
         std::cout << "creating new network and saving to disk" << std::endl;
-        static const std::vector<uint64_t> layer_sizes = { dataset->get_input_count(), 128, 64, 32,
-                                                           dataset->get_output_count() };
+        // sigmoid hidden layers, and a softmax over the digits trained against cross-entropy
+        using neuralnet::activation_function;
+        static const std::vector<neuralnet::layer_spec_t> layers = {
+            { 128, activation_function::sigmoid },
+            { 64, activation_function::sigmoid },
+            { 32, activation_function::sigmoid },
+            { dataset->get_output_count(), activation_function::softmax }
+        };
 
         network = neuralnet::unique(
-            neuralnet::network::randomize(layer_sizes, neuralnet::activation_function::sigmoid));
+            neuralnet::network::randomize(dataset->get_input_count(), layers));
 
         save_network(loader, network);
     }
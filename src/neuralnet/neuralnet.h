@@ -6,5 +6,12 @@
 #include "neuralnet/trainer.h"
 #include "neuralnet/loader.h"
 #include "neuralnet/util.h"
+#include "neuralnet/thread_pool.h"
+#include "neuralnet/arena.h"
+#include "neuralnet/quantization.h"
+#include "neuralnet/precision.h"
+#include "neuralnet/sparsity.h"
+#include "neuralnet/factorization.h"
+#include "neuralnet/static_network.h"
 
 #include "neuralnet/evaluators/evaluators.h"
\ No newline at end of file
@@ -0,0 +1,96 @@
+#include "nnpch.h"
+#include "neuralnet/arena.h"
+#include "neuralnet/util.h"
+
+namespace neuralnet {
+    arena::arena(size_t minimum_block_size) {
+        ZoneScoped;
+
+        m_current_block = 0;
+        m_offset = 0;
+        m_minimum_block_size = minimum_block_size;
+    }
+
+    arena::~arena() {
+        ZoneScoped;
+        free_blocks();
+    }
+
+    void* arena::allocate(size_t size, size_t alignment) {
+        ZoneScoped;
+
+        while (m_current_block < m_blocks.size()) {
+            const auto& block = m_blocks[m_current_block];
+
+            size_t base = (size_t)block.data;
+            size_t address = (base + m_offset + alignment - 1) & ~(alignment - 1);
+            size_t offset = address - base;
+
+            if (offset + size <= block.size) {
+                m_offset = offset + size;
+                return (void*)address;
+            }
+
+            m_current_block++;
+            m_offset = 0;
+        }
+
+        block_t block;
+        block.size = std::max(m_minimum_block_size, size + alignment);
+        block.data = aligned_alloc(block.size, default_alignment);
+
+        if (block.data == nullptr) {
+            throw std::runtime_error("failed to allocate arena block!");
+        }
+
+        m_blocks.push_back(block);
+        m_current_block = m_blocks.size() - 1;
+
+        size_t base = (size_t)block.data;
+        size_t address = (base + alignment - 1) & ~(alignment - 1);
+        m_offset = address - base + size;
+
+        return (void*)address;
+    }
+
+    void arena::reset() {
+        ZoneScoped;
+
+        if (m_blocks.size() > 1) {
+            size_t total_size = get_capacity();
+            free_blocks();
+
+            block_t block;
+            block.size = total_size;
+            block.data = aligned_alloc(block.size, default_alignment);
+
+            if (block.data == nullptr) {
+                throw std::runtime_error("failed to allocate arena block!");
+            }
+
+            m_blocks.push_back(block);
+        }
+
+        m_current_block = 0;
+        m_offset = 0;
+    }
+
+    size_t arena::get_capacity() const {
+        size_t capacity = 0;
+        for (const auto& block : m_blocks) {
+            capacity += block.size;
+        }
+
+        return capacity;
+    }
+
+    void arena::free_blocks() {
+        ZoneScoped;
+
+        for (const auto& block : m_blocks) {
+            aligned_free(block.data);
+        }
+
+        m_blocks.clear();
+    }
+} // namespace neuralnet
\ No newline at end of file
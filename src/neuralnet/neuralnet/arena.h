@@ -0,0 +1,41 @@
+#pragma once
+
+namespace neuralnet {
+    // bump-pointer allocator. allocations are never freed individually; reset() invalidates all of
+    // them at once and keeps the underlying storage for reuse
+    class NN_API arena {
+    public:
+        static constexpr size_t default_alignment = 64;
+
+        arena(size_t minimum_block_size = 64 * 1024);
+        ~arena();
+
+        arena(const arena&) = delete;
+        arena& operator=(const arena&) = delete;
+
+        void* allocate(size_t size, size_t alignment = default_alignment);
+
+        template <typename _Ty>
+        _Ty* allocate(size_t count) {
+            return (_Ty*)allocate(count * sizeof(_Ty), std::max(alignof(_Ty), default_alignment));
+        }
+
+        // if the previous cycle spilled over into several blocks, they are merged into a single
+        // block large enough to hold all of them. a repeated allocation pattern therefore stops
+        // touching the heap after its first cycle
+        void reset();
+
+        size_t get_capacity() const;
+
+    private:
+        struct block_t {
+            void* data;
+            size_t size;
+        };
+
+        void free_blocks();
+
+        std::vector<block_t> m_blocks;
+        size_t m_current_block, m_offset, m_minimum_block_size;
+    };
+} // namespace neuralnet
\ No newline at end of file
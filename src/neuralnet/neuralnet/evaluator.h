@@ -2,13 +2,15 @@
 #include "neuralnet/network.h"
 
 namespace neuralnet {
-    struct backprop_data_t {
+    template <typename _Ty>
+    struct basic_backprop_data_t {
         void* eval_outputs;
-        std::vector<number_t> expected_outputs;
+        std::vector<_Ty> expected_outputs;
     };
 
-    struct delta_composition_data_t {
-        network* nn;
+    template <typename _Ty>
+    struct basic_delta_composition_data_t {
+        basic_network<_Ty>* nn;
         std::vector<uint64_t> backprop_keys;
 
         // value to scale all delta weights & biases by
@@ -22,10 +24,17 @@ namespace neuralnet {
 
     enum class evaluator_type { cpu, vulkan, other };
 
-    class NN_API evaluator {
+    // evaluates networks of precision _Ty, see basic_network
+    template <typename _Ty>
+    class basic_evaluator {
     public:
-        evaluator() { m_training = false; }
-        virtual ~evaluator() = default;
+        using value_type = _Ty;
+        using network_type = basic_network<_Ty>;
+        using backprop_data_type = basic_backprop_data_t<_Ty>;
+        using delta_composition_data_type = basic_delta_composition_data_t<_Ty>;
+
+        basic_evaluator() { m_training = false; }
+        virtual ~basic_evaluator() = default;
 
         bool is_training() const { return m_training; }
         void set_training(bool training) { m_training = training; }
@@ -40,33 +49,52 @@ namespace neuralnet {
 
         // begins evaluating the provided neural network with the provided inputs, in the form of a
         // number array
-        virtual std::optional<uint64_t> begin_eval(const network* nn,
-                                                   const std::vector<number_t>& inputs) = 0;
+        virtual std::optional<uint64_t> begin_eval(const network_type* nn,
+                                                   const std::vector<_Ty>& inputs) = 0;
 
         // begins evaluating the provided neural network with the provided inputs, in the form of a
         // native container
-        virtual std::optional<uint64_t> begin_eval(const network* nn, void* native_inputs) = 0;
+        virtual std::optional<uint64_t> begin_eval(const network_type* nn, void* native_inputs) = 0;
 
         // retrieves the native result of the evaluation requested
         virtual bool get_eval_result(uint64_t result, void** outputs) = 0;
 
-        virtual void retrieve_eval_values(const network* nn, void* native_outputs,
-                                          std::vector<number_t>& outputs) = 0;
+        virtual void retrieve_eval_values(const network_type* nn, void* native_outputs,
+                                          std::vector<_Ty>& outputs) = 0;
 
         // begins performing backpropagation on the provided neural network, given previous
         // evaluation results
         // if asynchronous, the implementation must NOT reference the output from get_eval_result
         // during evaluation
-        virtual std::optional<uint64_t> begin_backprop(const network* nn,
-                                                       const backprop_data_t& data) = 0;
+        virtual std::optional<uint64_t> begin_backprop(const network_type* nn,
+                                                       const backprop_data_type& data) = 0;
 
         // composes deltas from the evaluator's memory into the canonical neural network layers
-        virtual bool compose_deltas(const delta_composition_data_t& data) = 0;
-
-        // cost function for training
-        virtual number_t cost_function(number_t actual, number_t expected) const = 0;
+        virtual bool compose_deltas(const delta_composition_data_type& data) = 0;
+
+        // cost function for training, of one output of a network with the given output layer
+        // activation function. softmax outputs are scored by cross-entropy, all others by squared
+        // error
+        virtual _Ty cost_function(_Ty actual, _Ty expected,
+                                  activation_function output_function) const = 0;
+
+        // works out, once, everything evaluating the provided neural network in batches of
+        // batch_size passes needs that does not depend on the inputs, in the current training
+        // mode, so that begin_eval & begin_backprop with that shape can skip their setup
+        // returns false if the implementation has no use for plans
+        virtual bool compile_plan(const network_type* /* nn */, uint64_t /* batch_size */) {
+            return false;
+        }
+
+        // drops every plan compiled for the provided neural network. results already begun are
+        // unaffected
+        virtual void release_plans(const network_type* /* nn */) {}
 
     private:
         bool m_training;
     };
+
+    using backprop_data_t = basic_backprop_data_t<number_t>;
+    using delta_composition_data_t = basic_delta_composition_data_t<number_t>;
+    using evaluator = basic_evaluator<number_t>;
 } // namespace neuralnet
\ No newline at end of file
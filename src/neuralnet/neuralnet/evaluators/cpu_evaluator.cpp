@@ -3,75 +3,362 @@
 #include "neuralnet/evaluators/evaluators.h"
 
 namespace neuralnet::evaluators {
-    struct cpu_backprop_data_t {
-        const cpu_result_t* eval_result;
-        const backprop_data_t* backprop_input;
-    };
+    template <typename _Ty>
+    static _Ty C(_Ty x, _Ty y) { return std::pow(x - y, 2); }
 
-    static number_t sigmoid(number_t x) { return 1 / (1 + std::exp(-x)); }
-    static number_t dsigmoid_dx(number_t x) {
-        number_t sig = sigmoid(x);
-        return sig * (1 - sig);
-    }
+    template <typename _Ty>
+    static _Ty dC_dx(_Ty x, _Ty y) { return 2 * (x - y); }
 
-    static number_t C(number_t x, number_t y) { return std::pow(x - y, 2); }
-    static number_t dC_dx(number_t x, number_t y) { return 2 * (x - y); }
+    // cost of a softmax output. taken through the softmax, its gradient is simply x - y (given
+    // targets that sum to 1), so backprop computes dC/dz directly instead of dC/da * da/dz
+    template <typename _Ty>
+    static _Ty cross_entropy(_Ty x, _Ty y) {
+        return -y * std::log(std::max(x, std::numeric_limits<_Ty>::min()));
+    }
 
-    static number_t A(activation_function func, number_t x) {
+    template <typename _Ty>
+    static void A(const basic_cpu_kernels_t<_Ty>& kernels, cpu_activation_accuracy accuracy,
+                  activation_function func, const _Ty* z, _Ty* a, size_t count) {
         switch (func) {
         case activation_function::sigmoid:
-            return sigmoid(x);
+            switch (accuracy) {
+            case cpu_activation_accuracy::fast:
+                kernels.fast_sigmoid(z, a, count);
+                break;
+            case cpu_activation_accuracy::table:
+                kernels.table_sigmoid(z, a, count);
+                break;
+            default:
+                kernels.sigmoid(z, a, count);
+                break;
+            }
+
+            break;
+        case activation_function::relu:
+            kernels.relu(z, a, count);
+            break;
+        case activation_function::leaky_relu:
+            kernels.leaky_relu(z, a, count, (_Ty)leaky_relu_slope);
+            break;
+        case activation_function::tanh:
+            kernels.tanh(z, a, count);
+            break;
+        case activation_function::gelu:
+            kernels.gelu(z, a, count);
+            break;
+        case activation_function::identity:
+            if (a != z) {
+                std::copy(z, z + count, a);
+            }
+
+            break;
+        case activation_function::softmax:
+            kernels.softmax(z, a, count);
+            break;
         default:
             throw std::runtime_error("invalid activation function!");
-            return 0;
         }
     }
 
-    static number_t dA_dz(activation_function func, number_t x) {
+    // multiplies dC/da by da/dz in place, computed from the stored pre-activations z or
+    // activations a, whichever the function needs
+    template <typename _Ty>
+    static void dA_dz(const basic_cpu_kernels_t<_Ty>& kernels, activation_function func,
+                      const _Ty* z, const _Ty* a, _Ty* dC_da, size_t count) {
         switch (func) {
         case activation_function::sigmoid:
-            return dsigmoid_dx(x);
+            kernels.sigmoid_gradient(a, dC_da, count);
+            break;
+        case activation_function::relu:
+            kernels.relu_gradient(a, dC_da, count);
+            break;
+        case activation_function::leaky_relu:
+            kernels.leaky_relu_gradient(a, dC_da, count, (_Ty)leaky_relu_slope);
+            break;
+        case activation_function::tanh:
+            kernels.tanh_gradient(a, dC_da, count);
+            break;
+        case activation_function::gelu:
+            kernels.gelu_gradient(z, dC_da, count);
+            break;
+        case activation_function::identity:
+            break;
         default:
             throw std::runtime_error("invalid activation function!");
-            return 0;
         }
     }
 
-    bool cpu_evaluator::is_result_ready(uint64_t result) const {
+    template <typename _Ty>
+    basic_cpu_evaluator<_Ty>::basic_cpu_evaluator(size_t thread_count) : m_pool(thread_count) {
+        ZoneScoped;
+
+        m_key = 0;
+        m_kernels = &get_cpu_kernels<_Ty>();
+        m_accuracy = cpu_activation_accuracy::precise;
+
+        // roughly where accumulating non-zero columns starts beating the dense product
+        m_sparse_threshold = 0.5f;
+
+        // likewise for sparse weights, see csr_multiply
+        m_sparse_weight_threshold = 0.3f;
+        m_parameter_format = parameter_format::fp32;
+        m_checkpoint_interval = 0;
+
+        m_stopping = false;
+        m_busy = false;
+        m_queue_head = m_queue_size = 0;
+        m_queue.resize(16);
+
+        m_worker = std::thread([this]() { worker(); });
+    }
+
+    template <typename _Ty>
+    basic_cpu_evaluator<_Ty>::~basic_cpu_evaluator() {
+        ZoneScoped;
+
+        wait_idle();
+        {
+            std::lock_guard lock(m_queue_mutex);
+            m_stopping = true;
+        }
+
+        m_queue_cv.notify_all();
+        m_worker.join();
+    }
+
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::set_kernel_isa(cpu_isa isa) {
+        ZoneScoped;
+
+        auto kernels = get_cpu_kernels<_Ty>(isa);
+        if (kernels == nullptr) {
+            return false;
+        }
+
+        // queued work may still be using the previous kernels, as may plans
+        wait_idle();
+
+        m_kernels = kernels;
+        m_plans.clear();
+        return true;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::set_activation_accuracy(cpu_activation_accuracy accuracy) {
+        ZoneScoped;
+
+        wait_idle();
+        m_accuracy = accuracy;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::set_sparse_input_threshold(number_t density) {
+        ZoneScoped;
+
+        // only read on the calling thread, by begin_eval
+        m_sparse_threshold = density;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::set_sparse_weight_threshold(number_t density) {
+        ZoneScoped;
+
+        // which layers are compressed depends on the threshold
+        wait_idle();
+
+        m_sparse_weight_threshold = density;
+        m_sparse_weights.clear();
+        m_plans.clear();
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::set_checkpoint_interval(size_t interval) {
+        ZoneScoped;
+
+        // queued work is laid out by the current plans
+        wait_idle();
+
+        m_checkpoint_interval = interval;
+        m_plans.clear();
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::set_parameter_format(parameter_format format) {
+        ZoneScoped;
+
+        // queued evaluations may still be reading the previous copies
+        wait_idle();
+
+        m_parameter_format = format;
+        m_reduced_weights.clear();
+        m_plans.clear();
+    }
+
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::is_result_ready(uint64_t result) const {
         ZoneScoped;
-        return m_results.find(result) != m_results.end();
+
+        auto it = m_results.find(result);
+        if (it == m_results.end() || it->second.freed) {
+            return false;
+        }
+
+        return it->second.ready.load(std::memory_order_acquire);
     }
 
-    bool cpu_evaluator::free_result(uint64_t result) {
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::free_result(uint64_t result) {
         ZoneScoped;
 
+        release_deferred();
         if (!is_result_ready(result)) {
             return false;
         }
 
-        auto& data = m_results[result];
-        for (void* ptr : data.results) {
-            switch (data.type) {
-            case cpu_result_type::backprop:
-                delete (layer_t*)ptr;
-                break;
-            default:
-                freemem(ptr);
-                break;
-            }
+        // a queued backprop pass may still be reading from this result
+        auto& data = m_results.at(result);
+        if (data.references.load(std::memory_order_acquire) > 0) {
+            data.freed = true;
+            m_deferred_frees.push_back(result);
+
+            return true;
         }
 
-        m_results.erase(result);
+        release_result(result);
         return true;
     }
 
+    template <typename _Ty>
+    basic_cpu_result_t<_Ty>& basic_cpu_evaluator<_Ty>::create_result(uint64_t key) {
+        ZoneScoped;
+
+        if (m_free_results.empty()) {
+            return m_results[key];
+        }
+
+        auto node = std::move(m_free_results.back());
+        m_free_results.pop_back();
+
+        node.key() = key;
+        return m_results.insert(std::move(node)).position->second;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::release_result(uint64_t key) {
+        ZoneScoped;
+
+        // keep the node, and with it the capacity of its arena and results vector, so that steady
+        // state evaluation does not touch the heap
+        auto node = m_results.extract(key);
+        node.mapped().data = nullptr;
+        node.mapped().memory.reset();
+
+        m_free_results.push_back(std::move(node));
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::release_deferred() {
+        ZoneScoped;
+
+        for (size_t i = 0; i < m_deferred_frees.size();) {
+            uint64_t key = m_deferred_frees[i];
+            auto& result = m_results.at(key);
+
+            if (result.references.load(std::memory_order_acquire) > 0) {
+                i++;
+                continue;
+            }
+
+            release_result(key);
+            m_deferred_frees[i] = m_deferred_frees.back();
+            m_deferred_frees.pop_back();
+        }
+    }
+
+    // allocates every block of a result in a single buffer, laid out as its plan says
+    template <typename _Ty>
+    static void allocate_result(basic_cpu_result_t<_Ty>& result) {
+        ZoneScoped;
+
+        const auto& plan = *result.plan;
+        result.inputs = result.expected_outputs = 0;
+
+        switch (result.type) {
+        case cpu_result_type::eval:
+            result.size = plan.eval_size;
+            result.inputs = plan.inputs;
+            result.layers = plan.eval_layers;
+            break;
+        case cpu_result_type::backprop:
+            result.size = plan.backprop_size;
+            result.expected_outputs = plan.expected_outputs;
+            result.layers = plan.backprop_layers;
+            break;
+        }
+
+        result.data = result.memory.template allocate<_Ty>(result.size);
+    }
+
+    // activations feeding into the given layer of an evaluation
+    template <typename _Ty>
+    static const _Ty* get_layer_inputs(const basic_cpu_result_t<_Ty>& result, size_t layer) {
+        size_t offset = layer > 0 ? result.layers[layer - 1].activations : result.inputs;
+        return &result.data[offset];
+    }
+
+    // fills basic_cpu_result_t::sparse_inputs if the inputs are sparse enough
+    template <typename _Ty>
+    static void compress_inputs(basic_cpu_result_t<_Ty>& result, number_t threshold) {
+        ZoneScoped;
+
+        result.sparse_inputs.offsets = nullptr;
+        result.sparse_inputs.indices = nullptr;
+        result.sparse_inputs.values = nullptr;
+
+        size_t input_count = result.nn->get_layers()[0].previous_size;
+        size_t total = input_count * result.passes;
+        const _Ty* inputs = &result.data[result.inputs];
+
+        size_t non_zero = 0;
+        for (size_t i = 0; i < total; i++) {
+            non_zero += inputs[i] != 0 ? 1 : 0;
+        }
+
+        if (total == 0 || (number_t)non_zero >= threshold * (number_t)total) {
+            return;
+        }
+
+        auto& sparse = result.sparse_inputs;
+        sparse.offsets = result.memory.template allocate<uint32_t>(result.passes + 1);
+        sparse.indices = result.memory.template allocate<uint32_t>(non_zero);
+        sparse.values = result.memory.template allocate<_Ty>(non_zero);
+
+        uint32_t entry = 0;
+        for (size_t pass = 0; pass < result.passes; pass++) {
+            sparse.offsets[pass] = entry;
+
+            const _Ty* pass_inputs = &inputs[pass * input_count];
+            for (size_t i = 0; i < input_count; i++) {
+                if (pass_inputs[i] != 0) {
+                    sparse.indices[entry] = (uint32_t)i;
+                    sparse.values[entry] = pass_inputs[i];
+                    entry++;
+                }
+            }
+        }
+
+        sparse.offsets[result.passes] = entry;
+    }
+
+    template <typename _Ty>
     struct cpu_inputs_t {
-        const number_t* data;
+        const _Ty* data;
         size_t count;
     };
 
-    std::optional<uint64_t> cpu_evaluator::begin_eval(const network* nn,
-                                                      const std::vector<number_t>& inputs) {
+    template <typename _Ty>
+    std::optional<uint64_t> basic_cpu_evaluator<_Ty>::begin_eval(const network_type* nn,
+                                                                 const std::vector<_Ty>& inputs) {
         ZoneScoped;
 
         const auto& layers = nn->get_layers();
@@ -79,14 +366,16 @@ namespace neuralnet::evaluators {
             return {};
         }
 
-        cpu_inputs_t input_data;
+        cpu_inputs_t<_Ty> input_data;
         input_data.data = inputs.data();
         input_data.count = inputs.size();
 
         return begin_eval(nn, &input_data);
     }
 
-    std::optional<uint64_t> cpu_evaluator::begin_eval(const network* nn, void* native_inputs) {
+    template <typename _Ty>
+    std::optional<uint64_t> basic_cpu_evaluator<_Ty>::begin_eval(const network_type* nn,
+                                                                 void* native_inputs) {
         ZoneScoped;
 
         const auto& layers = nn->get_layers();
@@ -94,25 +383,35 @@ namespace neuralnet::evaluators {
             return {};
         }
 
+        release_deferred();
+
         uint64_t key = m_key++;
-        auto& result = m_results[key];
+        auto& result = create_result(key);
 
-        auto inputs = (cpu_inputs_t*)native_inputs;
-        uint64_t input_count = layers[0].size;
+        auto inputs = (cpu_inputs_t<_Ty>*)native_inputs;
+        uint64_t input_count = layers[0].previous_size;
         size_t pass_count = (inputs->count - (inputs->count % input_count)) / input_count;
 
         result.type = cpu_result_type::eval;
         result.nn = nn;
         result.passes = pass_count;
+        result.training = this->is_training();
+        result.plan = &get_plan(nn, pass_count, result.training);
+        result.checkpoint_interval = result.plan->checkpoint_interval;
+        allocate_result(result);
 
-        for (size_t i = 0; i < pass_count; i++) {
-            eval(&inputs->data[i * layers.size()], result);
-        }
+        // the caller's buffer is only guaranteed to live until we return
+        size_t total_inputs = input_count * pass_count;
+        copy(inputs->data, &result.data[result.inputs], total_inputs * sizeof(_Ty));
+
+        compress_inputs(result, m_sparse_threshold);
 
+        submit(result);
         return key;
     }
 
-    bool cpu_evaluator::get_eval_result(uint64_t result, void** outputs) {
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::get_eval_result(uint64_t result, void** outputs) {
         ZoneScoped;
 
         if (!is_result_ready(result)) {
@@ -124,26 +423,33 @@ namespace neuralnet::evaluators {
             return false;
         }
 
+        if (cpu_result.exception) {
+            std::rethrow_exception(cpu_result.exception);
+        }
+
         *outputs = &cpu_result; // not much more specific you can be in this case
         return true;
     }
 
-    void cpu_evaluator::retrieve_eval_values(const network* nn, void* native_outputs,
-                                             std::vector<number_t>& outputs) {
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::retrieve_eval_values(const network_type* nn,
+                                                        void* native_outputs,
+                                                        std::vector<_Ty>& outputs) {
         ZoneScoped;
 
         const auto& layers = nn->get_layers();
         const auto& output_layer = layers[layers.size() - 1];
 
-        auto result = (cpu_result_t*)native_outputs;
-        void* layer_data = result->results[layers.size()];
+        auto result = (basic_cpu_result_t<_Ty>*)native_outputs;
+        const _Ty* activations = &result->data[result->layers[layers.size() - 1].activations];
 
-        outputs.resize(output_layer.size);
-        copy(layer_data, outputs.data(), output_layer.size * sizeof(number_t));
+        outputs.resize(output_layer.size * result->passes);
+        copy(activations, outputs.data(), outputs.size() * sizeof(_Ty));
     }
 
-    std::optional<uint64_t> cpu_evaluator::begin_backprop(const network* nn,
-                                                          const backprop_data_t& data) {
+    template <typename _Ty>
+    std::optional<uint64_t> basic_cpu_evaluator<_Ty>::begin_backprop(
+        const network_type* nn, const backprop_data_type& data) {
         ZoneScoped;
 
         const auto& layers = nn->get_layers();
@@ -151,187 +457,1405 @@ namespace neuralnet::evaluators {
             return {};
         }
 
-        auto eval_result = (cpu_result_t*)data.eval_outputs;
-        if (eval_result->type != cpu_result_type::eval || eval_result->nn != nn) {
+        // evaluations made outside of training mode do not keep their hidden layers
+        auto eval_result = (basic_cpu_result_t<_Ty>*)data.eval_outputs;
+        if (eval_result->type != cpu_result_type::eval || eval_result->nn != nn ||
+            !eval_result->training || !eval_result->ready.load(std::memory_order_acquire)) {
+            return {};
+        }
+
+        size_t output_count = layers[layers.size() - 1].size * eval_result->passes;
+        if (data.expected_outputs.size() < output_count) {
+            return {};
+        }
+
+        const auto& plan = get_plan(nn, eval_result->passes, true);
+        if (plan.checkpoint_interval != eval_result->checkpoint_interval) {
             return {};
         }
 
+        release_deferred();
+
         uint64_t key = m_key++;
-        auto& result = m_results[key];
+        auto& result = create_result(key);
 
         result.type = cpu_result_type::backprop;
         result.nn = nn;
         result.passes = eval_result->passes;
+        result.training = true;
+        result.source = eval_result;
+        result.plan = &plan;
+        result.checkpoint_interval = plan.checkpoint_interval;
+        allocate_result(result);
 
-        cpu_backprop_data_t backprop_data;
-        backprop_data.backprop_input = &data;
-        backprop_data.eval_result = eval_result;
+        copy(data.expected_outputs.data(), &result.data[result.expected_outputs],
+             output_count * sizeof(_Ty));
 
-        for (size_t i = 0; i < result.passes; i++) {
-            backprop(backprop_data, result, i * layers.size());
-        }
+        // released by the worker once the pass has been computed
+        eval_result->references.fetch_add(1, std::memory_order_relaxed);
 
+        submit(result);
         return key;
     }
 
-    bool cpu_evaluator::compose_deltas(const delta_composition_data_t& data) {
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::submit(basic_cpu_result_t<_Ty>& result) {
+        ZoneScoped;
+
+        result.ready.store(false, std::memory_order_relaxed);
+        result.freed = false;
+        result.exception = nullptr;
+
+        {
+            std::lock_guard lock(m_queue_mutex);
+            if (m_queue_size == m_queue.size()) {
+                // unroll the ring buffer into a larger one
+                std::vector<basic_cpu_result_t<_Ty>*> queue(m_queue.size() * 2);
+                for (size_t i = 0; i < m_queue_size; i++) {
+                    queue[i] = m_queue[(m_queue_head + i) % m_queue.size()];
+                }
+
+                m_queue = std::move(queue);
+                m_queue_head = 0;
+            }
+
+            m_queue[(m_queue_head + m_queue_size) % m_queue.size()] = &result;
+            m_queue_size++;
+        }
+
+        m_queue_cv.notify_one();
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::wait_idle() {
+        ZoneScoped;
+
+        std::unique_lock lock(m_queue_mutex);
+        m_idle_cv.wait(lock, [this]() { return m_queue_size == 0 && !m_busy; });
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::worker() {
+        while (true) {
+            basic_cpu_result_t<_Ty>* result;
+            {
+                std::unique_lock lock(m_queue_mutex);
+                m_queue_cv.wait(lock, [this]() { return m_stopping || m_queue_size > 0; });
+
+                if (m_queue_size == 0) {
+                    return;
+                }
+
+                result = m_queue[m_queue_head];
+                m_queue_head = (m_queue_head + 1) % m_queue.size();
+                m_queue_size--;
+                m_busy = true;
+            }
+
+            try {
+                execute(*result);
+            } catch (...) {
+                result->exception = std::current_exception();
+            }
+
+            if (result->type == cpu_result_type::backprop) {
+                result->source->references.fetch_sub(1, std::memory_order_release);
+            }
+
+            result->ready.store(true, std::memory_order_release);
+            {
+                std::lock_guard lock(m_queue_mutex);
+                m_busy = false;
+            }
+
+            m_idle_cv.notify_all();
+        }
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::execute(basic_cpu_result_t<_Ty>& result) {
+        ZoneScoped;
+
+        switch (result.type) {
+        case cpu_result_type::eval:
+            eval(result);
+            break;
+        case cpu_result_type::backprop:
+            backprop(result);
+            break;
+        }
+    }
+
+    // parameters per compose_deltas task; small enough to stay in l1 while every key's gradient
+    // streams through it
+    static constexpr size_t compose_chunk = 4096;
+
+    // applies every key's gradient to the parameters [begin, end) of a layer, counted over its
+    // biases and then its weights. each parameter is loaded and stored once per call, rather than
+    // once per key
+    template <typename _Ty>
+    static void compose_range(const basic_cpu_kernels_t<_Ty>& kernels, _Ty alpha,
+                              const _Ty* const* gradients, size_t key_count,
+                              basic_layer_t<_Ty>& layer, size_t begin, size_t end) {
+        ZoneScoped;
+
+        size_t size = layer.biases.size();
+        for (size_t offset = begin; offset < end; offset += compose_chunk) {
+            size_t offset_end = std::min(end, offset + compose_chunk);
+
+            // within a chunk, keys are innermost
+            if (offset < size) {
+                size_t bias_end = std::min(offset_end, size);
+                for (size_t k = 0; k < key_count; k++) {
+                    kernels.axpy(alpha, &gradients[k][offset], &layer.biases[offset],
+                                 bias_end - offset);
+                }
+            }
+
+            if (offset_end > size) {
+                size_t weight_begin = std::max(offset, size);
+                for (size_t k = 0; k < key_count; k++) {
+                    kernels.axpy(alpha, &gradients[k][weight_begin],
+                                 &layer.weights[weight_begin - size], offset_end - weight_begin);
+                }
+            }
+        }
+    }
+
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::compose_deltas(const delta_composition_data_type& data) {
         ZoneScoped;
+
+        release_deferred();
         for (uint64_t key : data.backprop_keys) {
-            if (!m_results.contains(key)) {
+            if (!is_result_ready(key)) {
                 return false;
             }
+
+            const auto& result = m_results.at(key);
+            if (result.exception) {
+                std::rethrow_exception(result.exception);
+            }
         }
 
+        // queued evaluations read the weights we are about to modify
+        wait_idle();
+
         auto& layers = data.nn->get_layers();
-        for (uint64_t key : data.backprop_keys) {
-            const auto& result = m_results.at(key);
+        size_t key_count = data.backprop_keys.size();
+
+        // every key's gradient block, layer-major, so that a layer's blocks are contiguous
+        m_compose_gradients.resize(layers.size() * key_count);
+        for (size_t k = 0; k < key_count; k++) {
+            const auto& result = m_results.at(data.backprop_keys[k]);
             if (result.nn != data.nn) {
                 throw std::runtime_error("network mismatch!");
             }
 
             for (size_t i = 0; i < layers.size(); i++) {
+                m_compose_gradients[i * key_count + k] = &result.data[result.layers[i].gradient];
+            }
+        }
+
+        // the parameters of every layer, biases then weights as gradient blocks are laid out,
+        // form one index space that is split between threads
+        m_compose_offsets.resize(layers.size() + 1);
+        m_compose_offsets[0] = 0;
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            m_compose_offsets[i + 1] =
+                m_compose_offsets[i] + layer.biases.size() + layer.weights.size();
+        }
+
+        _Ty alpha = (_Ty)-data.delta_scalar;
+        const auto& offsets = m_compose_offsets;
+
+        m_pool.parallel_for(offsets.back(), compose_chunk, [&](size_t begin, size_t end, size_t) {
+            // chunks may straddle layers
+            auto next = std::upper_bound(offsets.begin(), offsets.end(), begin);
+            size_t i = (size_t)(next - offsets.begin()) - 1;
+
+            for (; begin < end; i++) {
                 auto& layer = layers[i];
-                for (size_t j = 0; j < result.passes; j++) {
-                    auto delta = (layer_t*)result.results[j * layers.size() + i];
-                    if (delta->size != layer.size || delta->previous_size != layer.previous_size) {
-                        throw std::runtime_error("delta/layer size mismatch!");
-                    }
+                size_t layer_begin = begin - offsets[i];
+                size_t layer_end = std::min(end, offsets[i + 1]) - offsets[i];
 
-                    for (size_t c = 0; c < layer.size; c++) {
-                        number_t& bias = network::get_bias_address(layer, c);
-                        number_t bias_delta = network::get_bias(*delta, c);
-                        bias -= bias_delta * data.delta_scalar;
+                auto gradients = m_compose_gradients.data() + i * key_count;
+                compose_range(*m_kernels, alpha, gradients, key_count, layer, layer_begin,
+                              layer_end);
 
-                        for (size_t p = 0; p < layer.previous_size; p++) {
-                            number_t& weight = network::get_weight_address(layer, c, p);
-                            number_t weight_delta = network::get_weight(*delta, c, p);
-                            weight -= weight_delta * data.delta_scalar;
-                        }
-                    }
-                }
+                begin = offsets[i] + layer_end;
             }
+        });
+
+        // keep the copy read by backprop and sparse evaluations in sync
+        auto transposed = m_transposed_weights.find(data.nn);
+        if (transposed != m_transposed_weights.end()) {
+            update_transposed_weights(data.nn, transposed->second, false);
+        }
+
+        auto reduced = m_reduced_weights.find(data.nn);
+        if (reduced != m_reduced_weights.end()) {
+            update_reduced_weights(data.nn, reduced->second);
+        }
+
+        // training practically never lands a weight on exactly zero, so layers that were dense
+        // stay dense and only compressed ones are refreshed. pruning is what makes layers sparse,
+        // and is followed by invalidate_weights
+        auto sparse = m_sparse_weights.find(data.nn);
+        if (sparse != m_sparse_weights.end()) {
+            update_sparse_weights(data.nn, sparse->second, true);
         }
 
         return true;
     }
 
-    number_t cpu_evaluator::cost_function(number_t actual, number_t expected) const {
+    template <typename _Ty>
+    _Ty basic_cpu_evaluator<_Ty>::cost_function(_Ty actual, _Ty expected,
+                                                activation_function output_function) const {
+        if (output_function == activation_function::softmax) {
+            return cross_entropy(actual, expected);
+        }
+
         return C(actual, expected);
     }
 
-    void cpu_evaluator::eval(const number_t* inputs, cpu_result_t& result) {
+    // cache blocking parameters for dense_multiply
+    // a block of weights (block_rows x block_depth) is kept hot while every pass of the batch
+    // streams through it, instead of re-reading the whole weight matrix once per pass
+    static constexpr size_t block_rows = 64;
+    static constexpr size_t block_passes = 16;
+    static constexpr size_t block_depth = 256;
+
+    // computes out = inputs * matrix^T + bias over a range of passes and matrix rows
+    // inputs are laid out pass-major (passes x depth), as is out (passes x rows). the matrix is
+    // row-major (rows x depth), with elements of any type dot can read. bias may be null
+    template <typename _Ty, typename _Weight>
+    static void dense_multiply(_Ty (*dot)(const _Ty*, const _Weight*, size_t), const _Ty* inputs,
+                               const _Weight* matrix, const _Ty* bias, _Ty* out, size_t depth,
+                               size_t rows, size_t pass_begin, size_t pass_end, size_t row_begin,
+                               size_t row_end) {
         ZoneScoped;
-        const auto& layers = result.nn->get_layers();
 
-        std::vector<std::vector<number_t>> activations, z;
-        activations.resize(layers.size());
-        z.resize(layers.size());
-
-        for (size_t i = 0; i < layers.size(); i++) {
-            const auto& layer = layers[i];
+        for (size_t pass = pass_begin; pass < pass_end; pass++) {
+            _Ty* pass_out = &out[pass * rows];
+            if (bias != nullptr) {
+                copy(&bias[row_begin], &pass_out[row_begin],
+                     (row_end - row_begin) * sizeof(_Ty));
+            } else {
+                std::fill(&pass_out[row_begin], &pass_out[row_end], (_Ty)0);
+            }
+        }
 
-            auto& layer_activations = activations[i];
-            auto& layer_z = z[i];
+        for (size_t p0 = 0; p0 < depth; p0 += block_depth) {
+            size_t p1 = std::min(p0 + block_depth, depth);
 
-            layer_activations.resize(layer.size);
-            layer_z.resize(layer.size);
+            for (size_t c0 = row_begin; c0 < row_end; c0 += block_rows) {
+                size_t c1 = std::min(c0 + block_rows, row_end);
 
-            auto previous_activations = i > 0 ? activations[i - 1].data() : inputs;
-            for (uint64_t c = 0; c < layer.size; c++) {
-                number_t neuron_z = layer.biases[c];
+                for (size_t pass0 = pass_begin; pass0 < pass_end; pass0 += block_passes) {
+                    size_t pass1 = std::min(pass0 + block_passes, pass_end);
 
-                for (uint64_t p = 0; p < layer.previous_size; p++) {
-                    number_t weight = network::get_weight(layer, c, p);
-                    number_t previous_activation = previous_activations[p];
+                    for (size_t pass = pass0; pass < pass1; pass++) {
+                        const _Ty* pass_inputs = &inputs[pass * depth];
+                        _Ty* pass_out = &out[pass * rows];
 
-                    neuron_z = weight * previous_activation;
+                        for (size_t c = c0; c < c1; c++) {
+                            const _Weight* row = &matrix[c * depth];
+                            pass_out[c] += dot(&pass_inputs[p0], &row[p0], p1 - p0);
+                        }
+                    }
                 }
+            }
+        }
+    }
+
+    // computes out = inputs * matrix^T + bias like dense_multiply, from compressed inputs
+    // transposed is the matrix transposed (depth x rows); each non-zero input adds one contiguous
+    // row of it
+    template <typename _Ty>
+    static void sparse_multiply(const basic_cpu_kernels_t<_Ty>& kernels,
+                                const basic_cpu_sparse_inputs_t<_Ty>& inputs,
+                                const _Ty* transposed, const _Ty* bias, _Ty* out, size_t rows,
+                                size_t pass_begin, size_t pass_end, size_t row_begin,
+                                size_t row_end) {
+        ZoneScoped;
+
+        size_t row_count = row_end - row_begin;
+        for (size_t pass = pass_begin; pass < pass_end; pass++) {
+            _Ty* pass_out = &out[pass * rows + row_begin];
+            copy(&bias[row_begin], pass_out, row_count * sizeof(_Ty));
 
-                layer_z[c] = neuron_z;
-                layer_activations[c] = A(layer.function, neuron_z);
+            for (uint32_t i = inputs.offsets[pass]; i < inputs.offsets[pass + 1]; i++) {
+                const _Ty* row = &transposed[inputs.indices[i] * rows + row_begin];
+                kernels.axpy(inputs.values[i], row, pass_out, row_count);
             }
         }
+    }
+
+    // computes out = inputs * matrix^T + bias like dense_multiply, with the matrix compressed
+    // a block of passes is interleaved into scratch (matrix.columns x block_passes), so that each
+    // entry of a row multiplies contiguous inputs of every pass in the block rather than gathering
+    // them. blocks of at least half that are padded with zeros; smaller ones gather straight from
+    // the inputs of every pass, which is about half as fast per pass as an interleaved block
+    template <typename _Ty>
+    static void csr_multiply(const basic_cpu_kernels_t<_Ty>& kernels, const _Ty* inputs,
+                             const basic_sparse_weights_t<_Ty>& matrix, const _Ty* bias, _Ty* out,
+                             _Ty* scratch, size_t pass_begin, size_t pass_end, size_t row_begin,
+                             size_t row_end) {
+        ZoneScoped;
 
-        size_t result_count = layers.size() + 1;
-        for (size_t i = 0; i < result_count; i++) {
-            if (i == 0) {
-                size_t first_layer_size = layers[0].previous_size * sizeof(number_t);
-                void* first_layer = alloc(first_layer_size);
+        size_t depth = matrix.columns;
+        size_t rows = matrix.rows;
 
-                copy(inputs, first_layer, first_layer_size);
-                result.results.push_back(first_layer);
+        for (size_t pass0 = pass_begin; pass0 < pass_end; pass0 += block_passes) {
+            size_t pass1 = std::min(pass0 + block_passes, pass_end);
+            size_t width = pass1 - pass0;
+            bool interleaved = width >= block_passes / 2;
 
-                continue;
+            if (interleaved) {
+                for (size_t p = 0; p < depth; p++) {
+                    _Ty* column = &scratch[p * block_passes];
+                    for (size_t j = 0; j < width; j++) {
+                        column[j] = inputs[(pass0 + j) * depth + p];
+                    }
+
+                    std::fill(&column[width], &column[block_passes], (_Ty)0);
+                }
             }
 
-            size_t layer_index = i - 1;
-            auto& layer = layers[layer_index];
+            for (size_t c = row_begin; c < row_end; c++) {
+                uint32_t begin = matrix.offsets[c];
+                size_t count = matrix.offsets[c + 1] - begin;
 
-            size_t layer_size = layer.size * sizeof(number_t);
-            size_t data_size = layer_size * 2;
-            void* layer_data = alloc(data_size);
+                const _Ty* values = matrix.values.data() + begin;
+                const uint32_t* indices = matrix.indices.data() + begin;
 
-            // see cpu_result_t::results
-            copy(activations[layer_index].data(), layer_data, layer_size);
-            copy(z[layer_index].data(), (void*)((size_t)layer_data + layer_size), layer_size);
+                if (interleaved) {
+                    _Ty sums[block_passes];
+                    kernels.sparse_dot_interleaved(values, indices, scratch, count, sums,
+                                                   block_passes);
 
-            result.results.push_back(layer_data);
+                    for (size_t j = 0; j < width; j++) {
+                        out[(pass0 + j) * rows + c] = bias[c] + sums[j];
+                    }
+                } else {
+                    for (size_t pass = pass0; pass < pass1; pass++) {
+                        _Ty sum = kernels.sparse_dot(values, indices, &inputs[pass * depth], count);
+                        out[pass * rows + c] = bias[c] + sum;
+                    }
+                }
+            }
         }
     }
 
-    void cpu_evaluator::backprop(const cpu_backprop_data_t& data, cpu_result_t& result,
-                                 size_t offset) {
+    // dst (columns x rows) = src (rows x columns)^T, over a range of source rows
+    template <typename _Ty>
+    static void transpose(const _Ty* src, _Ty* dst, size_t rows, size_t columns,
+                          size_t row_begin, size_t row_end) {
         ZoneScoped;
-        size_t first_index = result.results.size();
 
-        const auto& layers = result.nn->get_layers();
-        for (int64_t i = layers.size() - 1; i >= 0; i--) {
-            const auto& layer = layers[i];
+        // square tiles, so that both sides are touched a cache line at a time
+        constexpr size_t tile = 16;
+        for (size_t r0 = row_begin; r0 < row_end; r0 += tile) {
+            size_t r1 = std::min(r0 + tile, row_end);
 
-            auto delta = new layer_t;
-            delta->size = layer.size;
-            delta->previous_size = layer.previous_size;
-            delta->biases.resize(delta->size);
-            delta->weights.resize(delta->size * delta->previous_size);
+            for (size_t c0 = 0; c0 < columns; c0 += tile) {
+                size_t c1 = std::min(c0 + tile, columns);
 
-            size_t result_offset = offset + i;
-            auto layer_data = (number_t*)data.eval_result->results[result_offset + 1];
-            auto previous_layer_data = (number_t*)data.eval_result->results[result_offset];
+                for (size_t r = r0; r < r1; r++) {
+                    for (size_t c = c0; c < c1; c++) {
+                        dst[c * rows + r] = src[r * columns + c];
+                    }
+                }
+            }
+        }
+    }
 
-            for (uint64_t c = 0; c < layer.size; c++) {
-                number_t z = layer_data[layer.size + c];
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::update_transposed_weights(
+        const network_type* nn, std::vector<std::vector<_Ty>>& transposed, bool input_layer) {
+        ZoneScoped;
 
-                number_t dC_da;
-                if (i == layers.size() - 1) {
-                    dC_da = dC_dx(data.backprop_input->expected_outputs[c], layer_data[c]);
-                } else {
-                    dC_da = 0;
+        // the first layer's weights are only needed transposed for sparse inputs; nothing
+        // propagates past it
+        const auto& layers = nn->get_layers();
+        input_layer |= !transposed.empty() && !transposed[0].empty();
+        transposed.resize(layers.size());
 
-                    size_t next_layer_index = i + 1;
-                    const auto& next_layer = layers[next_layer_index];
-                    const auto& next_delta = *(const layer_t*)result.results[first_index];
+        for (size_t i = input_layer ? 0 : 1; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            auto& layer_transposed = transposed[i];
+            layer_transposed.resize(layer.weights.size());
 
-                    for (size_t n = 0; n < next_layer.size; n++) {
-                        number_t weight = network::get_weight(next_layer, n, c);
-                        number_t dC_db_n = network::get_bias(next_delta, n);
-                        number_t dC_dz_n = dC_db_n / 1.f; // dz/db
+            m_pool.parallel_for(layer.size, block_rows, [&](size_t begin, size_t end, size_t) {
+                transpose(layer.weights.data(), layer_transposed.data(), layer.size,
+                          layer.previous_size, begin, end);
+            });
+        }
+    }
 
-                        dC_da += weight * dC_dz_n;
-                    }
-                }
+    template <typename _Ty>
+    const std::vector<std::vector<_Ty>>& basic_cpu_evaluator<_Ty>::get_transposed_weights(
+        const network_type* nn, bool input_layer) {
+        ZoneScoped;
 
-                number_t dC_dz = dC_da * dA_dz(layer.function, z);
-                network::get_bias_address(*delta, c) = dC_dz * 1.f; // dz/db
+        auto& transposed = m_transposed_weights[nn];
+        const auto& layers = nn->get_layers();
 
-                for (uint64_t p = 0; p < layer.previous_size; p++) {
-                    number_t previous_activation = previous_layer_data[p];
-                    network::get_weight_address(*delta, c, p) = dC_dz * previous_activation;
-                }
+        bool valid = transposed.size() == layers.size();
+        for (size_t i = 0; i < layers.size() && valid; i++) {
+            if (i > 0 || input_layer || !transposed[0].empty()) {
+                valid = transposed[i].size() == layers[i].weights.size();
             }
+        }
+
+        if (!valid) {
+            update_transposed_weights(nn, transposed, input_layer);
+        }
+
+        return transposed;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::update_reduced_weights(
+        const network_type* nn, std::vector<std::vector<uint16_t>>& reduced) {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        reduced.resize(layers.size());
 
-            auto it = result.results.begin();
-            std::advance(it, first_index);
-            result.results.insert(it, delta);
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            auto& layer_reduced = reduced[i];
+            layer_reduced.resize(layer.weights.size());
+
+            m_pool.parallel_for(layer.size, block_rows, [&](size_t begin, size_t end, size_t) {
+                size_t offset = begin * layer.previous_size;
+                reduce_parameters(&layer.weights[offset], &layer_reduced[offset],
+                                  (end - begin) * layer.previous_size, m_parameter_format);
+            });
         }
     }
+
+    template <typename _Ty>
+    const std::vector<std::vector<uint16_t>>& basic_cpu_evaluator<_Ty>::get_reduced_weights(
+        const network_type* nn) {
+        ZoneScoped;
+
+        auto& reduced = m_reduced_weights[nn];
+        const auto& layers = nn->get_layers();
+
+        bool valid = reduced.size() == layers.size();
+        for (size_t i = 0; i < layers.size() && valid; i++) {
+            valid = reduced[i].size() == layers[i].weights.size();
+        }
+
+        if (!valid) {
+            update_reduced_weights(nn, reduced);
+        }
+
+        return reduced;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::update_sparse_weights(
+        const network_type* nn, std::vector<basic_sparse_weights_t<_Ty>>& sparse,
+        bool compressed_only) {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        sparse.resize(layers.size());
+
+        // a network with no sparse layers is left alone, without reading any of its weights
+        auto is_dense = [](const basic_sparse_weights_t<_Ty>& layer) {
+            return layer.offsets.empty();
+        };
+
+        if (compressed_only && std::all_of(sparse.begin(), sparse.end(), is_dense)) {
+            return;
+        }
+
+        m_pool.parallel_for(layers.size(), 1, [&](size_t begin, size_t end, size_t) {
+            for (size_t i = begin; i < end; i++) {
+                const auto& layer = layers[i];
+                auto& layer_sparse = sparse[i];
+
+                if (compressed_only && is_dense(layer_sparse)) {
+                    continue;
+                }
+
+                if (get_weight_density(layer) < m_sparse_weight_threshold) {
+                    compress_weights(layer, layer_sparse);
+                } else {
+                    layer_sparse.rows = layer_sparse.columns = 0;
+                    layer_sparse.offsets.clear();
+                    layer_sparse.indices.clear();
+                    layer_sparse.values.clear();
+                }
+            }
+        });
+    }
+
+    template <typename _Ty>
+    const std::vector<basic_sparse_weights_t<_Ty>>& basic_cpu_evaluator<_Ty>::get_sparse_weights(
+        const network_type* nn) {
+        ZoneScoped;
+
+        auto& sparse = m_sparse_weights[nn];
+        if (sparse.size() != nn->get_layers().size()) {
+            update_sparse_weights(nn, sparse, false);
+        }
+
+        return sparse;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::invalidate_weights(const network_type* nn) {
+        ZoneScoped;
+
+        wait_idle();
+        m_transposed_weights.erase(nn);
+        m_reduced_weights.erase(nn);
+        m_sparse_weights.erase(nn);
+
+        release_plans(nn);
+    }
+
+    // whether evaluations keep a layer's activations (and in training, pre-activations) in their
+    // result. the output layer is always kept
+    static bool keeps_layer(size_t layer, size_t layer_count, bool training,
+                            size_t checkpoint_interval) {
+        if (layer + 1 == layer_count) {
+            return true;
+        }
+
+        return training && (checkpoint_interval == 0 || (layer + 1) % checkpoint_interval == 0);
+    }
+
+    // lays out every block of a result in a single buffer, see cpu_layer_offsets_t
+    // blocks start on cache line boundaries so that no two of them share a line
+    template <typename _Ty>
+    static void lay_out_results(basic_cpu_execution_plan_t<_Ty>& plan) {
+        ZoneScoped;
+
+        constexpr size_t block_alignment = arena::default_alignment / sizeof(_Ty);
+        size_t offset = 0;
+
+        auto reserve = [&](size_t count) {
+            size_t block = offset;
+            offset = (offset + count + block_alignment - 1) / block_alignment * block_alignment;
+
+            return block;
+        };
+
+        const auto& layers = plan.nn->get_layers();
+        size_t passes = plan.passes;
+        size_t interval = plan.checkpoint_interval;
+
+        plan.inputs = reserve(layers[0].previous_size * passes);
+        plan.eval_layers.resize(layers.size());
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            auto& offsets = plan.eval_layers[i];
+            offsets.activations = offsets.z = offsets.deltas = offsets.gradient = 0;
+
+            if (keeps_layer(i, layers.size(), plan.training, interval)) {
+                offsets.activations = reserve(layers[i].size * passes);
+                if (plan.training) {
+                    offsets.z = reserve(layers[i].size * passes);
+                }
+            }
+        }
+
+        plan.eval_size = offset;
+        offset = 0;
+
+        plan.expected_outputs = plan.backprop_size = 0;
+        plan.backprop_layers.clear();
+
+        if (!plan.training) {
+            return;
+        }
+
+        plan.expected_outputs = reserve(layers[layers.size() - 1].size * passes);
+        plan.backprop_layers.resize(layers.size());
+
+        // with checkpointing, a layer's deltas are only read until the previous layer's are
+        // computed
+        size_t delta_blocks[2];
+        if (interval > 0) {
+            size_t width = 0;
+            for (const auto& layer : layers) {
+                width = std::max<size_t>(width, layer.size);
+            }
+
+            delta_blocks[0] = reserve(width * passes);
+            delta_blocks[1] = reserve(width * passes);
+        }
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            auto& offsets = plan.backprop_layers[i];
+            offsets.activations = offsets.z = 0;
+            offsets.deltas = interval > 0 ? delta_blocks[i % 2] : reserve(layers[i].size * passes);
+            offsets.gradient = reserve(layers[i].size * (1 + layers[i].previous_size));
+        }
+
+        // layers between two checkpoints, recomputed by backprop. every segment starts at the
+        // same offset, but the layers of one never share blocks: backprop recomputes them in
+        // blocks of passes that do not wait on each other, see basic_cpu_evaluator::eval
+        size_t segment_begin = offset;
+        size_t end = offset;
+
+        for (size_t i = 0; interval > 0 && i < layers.size(); i++) {
+            if (keeps_layer(i, layers.size(), true, interval)) {
+                continue;
+            }
+
+            if (i % interval == 0) {
+                offset = segment_begin;
+            }
+
+            auto& offsets = plan.backprop_layers[i];
+            offsets.activations = reserve(layers[i].size * passes);
+            offsets.z = reserve(layers[i].size * passes);
+
+            end = std::max(end, offset);
+        }
+
+        plan.backprop_size = end;
+    }
+
+    template <typename _Ty>
+    const basic_cpu_execution_plan_t<_Ty>& basic_cpu_evaluator<_Ty>::get_plan(
+        const network_type* nn, size_t passes, bool training) {
+        ZoneScoped;
+
+        auto key = std::make_tuple(nn, passes, training);
+        auto it = m_plans.find(key);
+        if (it != m_plans.end()) {
+            return it->second;
+        }
+
+        auto& plan = m_plans[key];
+        plan.nn = nn;
+        plan.passes = passes;
+        plan.training = training;
+        plan.checkpoint_interval = m_checkpoint_interval > 1 ? m_checkpoint_interval : 0;
+        lay_out_results(plan);
+
+        switch (m_parameter_format) {
+        case parameter_format::fp16:
+            plan.reduced_dot = m_kernels->dot_f16;
+            break;
+        case parameter_format::bf16:
+            plan.reduced_dot = m_kernels->dot_bf16;
+            break;
+        default:
+            plan.reduced_dot = nullptr;
+            break;
+        }
+
+        // layers that are not kept alternate between two scratch buffers. csr_multiply
+        // interleaves up to block_passes passes of a layer's inputs. which layers are sparse
+        // changes as the network trains, so every layer is accounted for
+        const auto& layers = nn->get_layers();
+        size_t width = 0;
+        size_t csr_width = 0;
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            csr_width = std::max<size_t>(csr_width, layers[i].previous_size);
+            if (!keeps_layer(i, layers.size(), training, plan.checkpoint_interval)) {
+                width = std::max<size_t>(width, layers[i].size);
+            }
+        }
+
+        plan.inference_scratch_width = width;
+        plan.inference_scratch_size = width * passes;
+        plan.csr_scratch_size = m_sparse_weight_threshold > 0 ? csr_width * block_passes : 0;
+
+        size_t thread_count = m_pool.get_thread_count();
+        plan.split_passes = passes >= thread_count;
+        plan.pass_grain = std::min(block_passes, (passes + thread_count - 1) / thread_count);
+
+        return plan;
+    }
+
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::compile_plan(const network_type* nn, uint64_t batch_size) {
+        ZoneScoped;
+
+        if (nn->get_layers().empty() || batch_size == 0) {
+            return false;
+        }
+
+        const auto& plan = get_plan(nn, (size_t)batch_size, this->is_training());
+
+        // the worker sizes scratch memory as it needs it; do it now instead
+        wait_idle();
+
+        if (m_inference_scratch.size() < plan.inference_scratch_size * 2) {
+            m_inference_scratch.resize(plan.inference_scratch_size * 2);
+        }
+
+        size_t csr_scratch_size = plan.csr_scratch_size * m_pool.get_thread_count();
+        if (m_csr_scratch.size() < csr_scratch_size) {
+            m_csr_scratch.resize(csr_scratch_size);
+        }
+
+        return true;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::release_plans(const network_type* nn) {
+        ZoneScoped;
+
+        wait_idle();
+        std::erase_if(m_plans, [nn](const auto& entry) { return std::get<0>(entry.first) == nn; });
+    }
+
+    template <typename _Ty>
+    typename basic_cpu_evaluator<_Ty>::layer_sources_t
+    basic_cpu_evaluator<_Ty>::get_layer_sources(const result_type& eval_result) {
+        ZoneScoped;
+
+        layer_sources_t sources;
+        sources.input_weights = nullptr;
+        sources.reduced_weights = nullptr;
+        sources.sparse_weights = nullptr;
+
+        // compressed inputs are multiplied against the first layer's weights column by column
+        if (eval_result.sparse_inputs.offsets != nullptr) {
+            sources.input_weights = get_transposed_weights(eval_result.nn, true)[0].data();
+        }
+
+        // dense layers read 16-bit weights, widened as they are multiplied
+        if (eval_result.plan->reduced_dot != nullptr) {
+            sources.reduced_weights = &get_reduced_weights(eval_result.nn);
+        }
+
+        // sparse layers read their compressed copy instead, in full precision. every thread
+        // interleaves its block of passes into its own slice of m_csr_scratch
+        if (m_sparse_weight_threshold > 0) {
+            sources.sparse_weights = &get_sparse_weights(eval_result.nn);
+
+            size_t total_size = eval_result.plan->csr_scratch_size * m_pool.get_thread_count();
+            if (m_csr_scratch.size() < total_size) {
+                m_csr_scratch.resize(total_size);
+            }
+        }
+
+        return sources;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::multiply_layer(const layer_sources_t& sources,
+                                                  const result_type& eval_result,
+                                                  size_t layer_index,
+                                                  const _Ty* previous_activations, _Ty* z,
+                                                  size_t pass_begin, size_t pass_end,
+                                                  size_t row_begin, size_t row_end,
+                                                  size_t thread_index) {
+        const auto& plan = *eval_result.plan;
+        const auto& layer = eval_result.nn->get_layers()[layer_index];
+
+        const basic_sparse_weights_t<_Ty>* layer_sparse = nullptr;
+        if (sources.sparse_weights != nullptr &&
+            !(*sources.sparse_weights)[layer_index].offsets.empty()) {
+            layer_sparse = &(*sources.sparse_weights)[layer_index];
+        }
+
+        if (layer_index == 0 && sources.input_weights != nullptr) {
+            sparse_multiply(*m_kernels, eval_result.sparse_inputs, sources.input_weights,
+                            layer.biases.data(), z, layer.size, pass_begin, pass_end, row_begin,
+                            row_end);
+        } else if (layer_sparse != nullptr) {
+            _Ty* csr_scratch = &m_csr_scratch[thread_index * plan.csr_scratch_size];
+            csr_multiply(*m_kernels, previous_activations, *layer_sparse, layer.biases.data(), z,
+                         csr_scratch, pass_begin, pass_end, row_begin, row_end);
+        } else if (sources.reduced_weights != nullptr) {
+            dense_multiply(plan.reduced_dot, previous_activations,
+                           (*sources.reduced_weights)[layer_index].data(), layer.biases.data(), z,
+                           layer.previous_size, layer.size, pass_begin, pass_end, row_begin,
+                           row_end);
+        } else {
+            dense_multiply(m_kernels->dot, previous_activations, layer.weights.data(),
+                           layer.biases.data(), z, layer.previous_size, layer.size, pass_begin,
+                           pass_end, row_begin, row_end);
+        }
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::eval(basic_cpu_result_t<_Ty>& result) {
+        ZoneScoped;
+        const auto& layers = result.nn->get_layers();
+        const auto& plan = *result.plan;
+
+        // layers the result does not keep (every hidden layer outside of training, and those
+        // between checkpoints in training) alternate between two scratch buffers, with their
+        // pre-activations overwritten by their activations. backprop recomputes the latter into
+        // its own result, see lay_out_results
+        auto kept = [&](size_t layer) {
+            return keeps_layer(layer, layers.size(), result.training, plan.checkpoint_interval);
+        };
+
+        _Ty* scratch[2] = { nullptr, nullptr };
+        if (plan.inference_scratch_size > 0) {
+            size_t scratch_size = plan.inference_scratch_size;
+            if (m_inference_scratch.size() < scratch_size * 2) {
+                m_inference_scratch.resize(scratch_size * 2);
+            }
+
+            scratch[0] = m_inference_scratch.data();
+            scratch[1] = &scratch[0][scratch_size];
+        }
+
+        // blocks of passes run through the network without waiting on each other, so every block
+        // owns the scratch of its passes at a fixed stride, [slice, slice + passes) * width, and
+        // lays each layer out pass-major within it. a layer of the same parity can then never
+        // overwrite rows another block has yet to read, whatever their widths. blocks that start
+        // at pass 0 see the plain pass * size layout
+        auto get_scratch = [&](size_t layer_index, size_t slice) {
+            size_t shift = plan.inference_scratch_width - layers[layer_index].size;
+            return scratch[layer_index % 2] + slice * shift;
+        };
+
+        auto sources = get_layer_sources(result);
+        auto eval_layer = [&](size_t layer_index, size_t slice, size_t pass_begin,
+                              size_t pass_end, size_t row_begin, size_t row_end,
+                              size_t thread_index) {
+            const auto& layer = layers[layer_index];
+            const auto& offsets = result.layers[layer_index];
+
+            const _Ty* previous_activations;
+            if (layer_index == 0 || kept(layer_index - 1)) {
+                previous_activations = get_layer_inputs(result, layer_index);
+            } else {
+                previous_activations = get_scratch(layer_index - 1, slice);
+            }
+
+            _Ty *activations, *z;
+            if (kept(layer_index)) {
+                activations = &result.data[offsets.activations];
+                z = result.training ? &result.data[offsets.z] : activations;
+            } else {
+                activations = z = get_scratch(layer_index, slice);
+            }
+
+            multiply_layer(sources, result, layer_index, previous_activations, z, pass_begin,
+                           pass_end, row_begin, row_end, thread_index);
+
+            for (size_t pass = pass_begin; pass < pass_end; pass++) {
+                size_t offset = pass * layer.size + row_begin;
+                A(*m_kernels, m_accuracy, layer.function, &z[offset], &activations[offset],
+                  row_end - row_begin);
+            }
+        };
+
+        // with enough passes, every thread runs whole blocks of passes through the entire
+        // network, each in its own slice of scratch. otherwise, split each layer's neurons across
+        // threads instead, with every layer finished before the next begins, so that all of them
+        // share one slice
+        if (plan.split_passes) {
+            m_pool.parallel_for(result.passes, plan.pass_grain,
+                                [&](size_t begin, size_t end, size_t thread_index) {
+                                    for (size_t i = 0; i < layers.size(); i++) {
+                                        eval_layer(i, begin, begin, end, 0, layers[i].size,
+                                                   thread_index);
+                                    }
+                                });
+        } else {
+            for (size_t i = 0; i < layers.size(); i++) {
+                // softmax normalizes over every neuron of a pass, so its passes are split instead
+                if (layers[i].function == activation_function::softmax) {
+                    m_pool.parallel_for(result.passes, block_passes,
+                                        [&](size_t begin, size_t end, size_t thread_index) {
+                                            eval_layer(i, 0, begin, end, 0, layers[i].size,
+                                                       thread_index);
+                                        });
+
+                    continue;
+                }
+
+                m_pool.parallel_for(layers[i].size, block_rows,
+                                    [&](size_t begin, size_t end, size_t thread_index) {
+                                        eval_layer(i, 0, 0, result.passes, begin, end,
+                                                   thread_index);
+                                    });
+            }
+        }
+    }
+
+    template <typename _Ty>
+    void basic_cpu_workspace_t<_Ty>::reserve(const basic_network<_Ty>* nn) {
+        ZoneScoped;
+
+        // the output layer is written straight to the caller's buffer
+        const auto& layers = nn->get_layers();
+        size_t width = 0;
+
+        for (size_t i = 0; i + 1 < layers.size(); i++) {
+            width = std::max<size_t>(width, layers[i].size);
+        }
+
+        if (scratch.size() < width * 2) {
+            scratch.resize(width * 2);
+        }
+    }
+
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::infer(const network_type* nn, std::span<const _Ty> inputs,
+                                         std::span<_Ty> outputs, workspace_type& workspace) const {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        if (layers.empty() || inputs.size() != layers[0].previous_size ||
+            outputs.size() != layers[layers.size() - 1].size) {
+            return false;
+        }
+
+        workspace.reserve(nn);
+        _Ty* scratch[2] = { workspace.scratch.data(),
+                            &workspace.scratch[workspace.scratch.size() / 2] };
+
+        // same ping-pong as an inference evaluation, with a batch of one
+        const _Ty* previous_activations = inputs.data();
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            _Ty* activations = i + 1 < layers.size() ? scratch[i % 2] : outputs.data();
+
+            dense_multiply(m_kernels->dot, previous_activations, layer.weights.data(),
+                           layer.biases.data(), activations, layer.previous_size, layer.size, 0,
+                           1, 0, layer.size);
+
+            A(*m_kernels, m_accuracy, layer.function, activations, activations, layer.size);
+            previous_activations = activations;
+        }
+
+        return true;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_workspace_t<_Ty>::reserve(const quantized_network* nn) {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        size_t width = 0;
+        size_t input_width = 0;
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            input_width = std::max<size_t>(input_width, layers[i].previous_size);
+            if (i + 1 < layers.size()) {
+                width = std::max<size_t>(width, layers[i].size);
+            }
+        }
+
+        if (scratch.size() < width * 2) {
+            scratch.resize(width * 2);
+        }
+
+        if (quantized_inputs.size() < input_width) {
+            quantized_inputs.resize(input_width);
+        }
+    }
+
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::infer(const quantized_network* nn, std::span<const _Ty> inputs,
+                                         std::span<_Ty> outputs, workspace_type& workspace) const
+        requires std::is_same_v<_Ty, number_t>
+    {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        if (layers.empty() || inputs.size() != layers[0].previous_size ||
+            outputs.size() != layers[layers.size() - 1].size) {
+            return false;
+        }
+
+        workspace.reserve(nn);
+        _Ty* scratch[2] = { workspace.scratch.data(),
+                            &workspace.scratch[workspace.scratch.size() / 2] };
+
+        int8_t* quantized_inputs = workspace.quantized_inputs.data();
+        const _Ty* previous_activations = inputs.data();
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            _Ty* activations = i + 1 < layers.size() ? scratch[i % 2] : outputs.data();
+
+            _Ty minimum = layer.unsigned_inputs ? 0 : -127;
+            m_kernels->quantize_i8(previous_activations, quantized_inputs, layer.previous_size,
+                                   1 / layer.input_scale, minimum);
+
+            for (uint64_t c = 0; c < layer.size; c++) {
+                const int8_t* row = &layer.weights[c * layer.previous_size];
+
+                int32_t sum;
+                if (layer.unsigned_inputs) {
+                    sum = m_kernels->dot_u8i8((const uint8_t*)quantized_inputs, row,
+                                              layer.previous_size);
+                } else {
+                    sum = m_kernels->dot_i8(row, quantized_inputs, layer.previous_size);
+                }
+
+                _Ty scale = layer.weight_scales[c] * layer.input_scale;
+                activations[c] = (_Ty)sum * scale + layer.biases[c];
+            }
+
+            A(*m_kernels, m_accuracy, layer.function, activations, activations, layer.size);
+            previous_activations = activations;
+        }
+
+        return true;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_workspace_t<_Ty>::reserve(const factorized_network* nn) {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        size_t width = 0;
+        size_t rank = 0;
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            rank = std::max<size_t>(rank, layers[i].rank);
+            if (i + 1 < layers.size()) {
+                width = std::max<size_t>(width, layers[i].size);
+            }
+        }
+
+        if (scratch.size() < width * 2) {
+            scratch.resize(width * 2);
+        }
+
+        if (projected.size() < rank) {
+            projected.resize(rank);
+        }
+    }
+
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::infer(const factorized_network* nn, std::span<const _Ty> inputs,
+                                         std::span<_Ty> outputs, workspace_type& workspace) const
+        requires std::is_same_v<_Ty, number_t>
+    {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        if (layers.empty() || inputs.size() != layers[0].previous_size ||
+            outputs.size() != layers[layers.size() - 1].size) {
+            return false;
+        }
+
+        workspace.reserve(nn);
+        _Ty* scratch[2] = { workspace.scratch.data(),
+                            &workspace.scratch[workspace.scratch.size() / 2] };
+
+        _Ty* projected = workspace.projected.data();
+        const _Ty* previous_activations = inputs.data();
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            _Ty* activations = i + 1 < layers.size() ? scratch[i % 2] : outputs.data();
+
+            if (layer.rank > 0) {
+                dense_multiply(m_kernels->dot, previous_activations, layer.down.data(),
+                               (const _Ty*)nullptr, projected, layer.previous_size, layer.rank, 0,
+                               1, 0, layer.rank);
+
+                dense_multiply(m_kernels->dot, (const _Ty*)projected, layer.up.data(),
+                               layer.biases.data(), activations, layer.rank, layer.size, 0, 1, 0,
+                               layer.size);
+            } else {
+                dense_multiply(m_kernels->dot, previous_activations, layer.weights.data(),
+                               layer.biases.data(), activations, layer.previous_size, layer.size,
+                               0, 1, 0, layer.size);
+            }
+
+            A(*m_kernels, m_accuracy, layer.function, activations, activations, layer.size);
+            previous_activations = activations;
+        }
+
+        return true;
+    }
+
+    template <typename _Ty>
+    void basic_cpu_workspace_t<_Ty>::reserve(const reduced_network* nn) {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        size_t width = 0;
+
+        for (size_t i = 0; i + 1 < layers.size(); i++) {
+            width = std::max<size_t>(width, layers[i].size);
+        }
+
+        if (scratch.size() < width * 2) {
+            scratch.resize(width * 2);
+        }
+    }
+
+    template <typename _Ty>
+    bool basic_cpu_evaluator<_Ty>::infer(const reduced_network* nn, std::span<const _Ty> inputs,
+                                         std::span<_Ty> outputs, workspace_type& workspace) const
+        requires std::is_same_v<_Ty, number_t>
+    {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        if (layers.empty() || inputs.size() != layers[0].previous_size ||
+            outputs.size() != layers[layers.size() - 1].size) {
+            return false;
+        }
+
+        auto dot = nn->get_format() == parameter_format::bf16 ? m_kernels->dot_bf16
+                                                               : m_kernels->dot_f16;
+
+        workspace.reserve(nn);
+        _Ty* scratch[2] = { workspace.scratch.data(),
+                            &workspace.scratch[workspace.scratch.size() / 2] };
+
+        const _Ty* previous_activations = inputs.data();
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            _Ty* activations = i + 1 < layers.size() ? scratch[i % 2] : outputs.data();
+
+            dense_multiply(dot, previous_activations, layer.weights.data(), layer.biases.data(),
+                           activations, layer.previous_size, layer.size, 0, 1, 0, layer.size);
+
+            A(*m_kernels, m_accuracy, layer.function, activations, activations, layer.size);
+            previous_activations = activations;
+        }
+
+        return true;
+    }
+
+    // these accumulate the gradient of a layer over a range of its rows (neurons)
+    // grad_b = sum of deltas over the batch, grad_w = deltas^T * previous_activations
+    // deltas are laid out pass-major (passes x size), as are the activations (passes x previous)
+    template <typename _Ty>
+    static void bias_gradient(const _Ty* deltas, _Ty* gradient, size_t size, size_t passes,
+                              size_t row_begin, size_t row_end) {
+        ZoneScoped;
+
+        for (size_t c = row_begin; c < row_end; c++) {
+            _Ty sum = 0;
+            for (size_t pass = 0; pass < passes; pass++) {
+                sum += deltas[pass * size + c] * 1.f; // dz/db
+            }
+
+            gradient[c] = sum;
+        }
+    }
+
+    template <typename _Ty>
+    static void dense_gradient(const basic_cpu_kernels_t<_Ty>& kernels, const _Ty* deltas,
+                               const _Ty* previous_activations, const basic_layer_t<_Ty>& layer,
+                               _Ty* weight_gradient, size_t passes, size_t row_begin,
+                               size_t row_end) {
+        ZoneScoped;
+
+        size_t size = layer.size;
+        size_t previous_size = layer.previous_size;
+
+        std::fill(&weight_gradient[row_begin * previous_size],
+                  &weight_gradient[row_end * previous_size], (_Ty)0);
+
+        // a block of passes stays in cache while every row in the range accumulates from it
+        for (size_t pass0 = 0; pass0 < passes; pass0 += block_passes) {
+            size_t pass1 = std::min(pass0 + block_passes, passes);
+
+            for (size_t c = row_begin; c < row_end; c++) {
+                _Ty* row = &weight_gradient[c * previous_size];
+                for (size_t pass = pass0; pass < pass1; pass++) {
+                    _Ty dC_dz = deltas[pass * size + c];
+                    kernels.axpy(dC_dz, &previous_activations[pass * previous_size], row,
+                                 previous_size);
+                }
+            }
+        }
+    }
+
+    // accumulates the transpose of a layer's weight gradient from compressed inputs, over a
+    // range of input columns: row j gains value * dC/dz of the pass for every non-zero input j
+    // transposed_gradient is (previous_size x size)
+    template <typename _Ty>
+    static void sparse_gradient(const basic_cpu_kernels_t<_Ty>& kernels, const _Ty* deltas,
+                                const basic_cpu_sparse_inputs_t<_Ty>& inputs,
+                                _Ty* transposed_gradient, size_t size, size_t passes,
+                                size_t column_begin, size_t column_end) {
+        ZoneScoped;
+
+        std::fill(&transposed_gradient[column_begin * size],
+                  &transposed_gradient[column_end * size], (_Ty)0);
+
+        for (size_t pass = 0; pass < passes; pass++) {
+            const _Ty* pass_deltas = &deltas[pass * size];
+
+            for (uint32_t i = inputs.offsets[pass]; i < inputs.offsets[pass + 1]; i++) {
+                uint32_t column = inputs.indices[i];
+                if (column >= column_begin && column < column_end) {
+                    kernels.axpy(inputs.values[i], pass_deltas, &transposed_gradient[column * size],
+                                 size);
+                }
+            }
+        }
+    }
+
+    template <typename _Ty>
+    void basic_cpu_evaluator<_Ty>::backprop(basic_cpu_result_t<_Ty>& result) {
+        ZoneScoped;
+
+        const auto& layers = result.nn->get_layers();
+        const auto& eval_result = *result.source;
+        size_t passes = result.passes;
+
+        const auto& transposed_weights = get_transposed_weights(result.nn, false);
+        const _Ty* expected_outputs = &result.data[result.expected_outputs];
+
+        // layers between checkpoints are recomputed from the checkpoint below them, one segment
+        // at a time, as backprop reaches them
+        size_t interval = result.checkpoint_interval;
+        auto kept = [&](size_t layer) {
+            return keeps_layer(layer, layers.size(), true, interval);
+        };
+
+        auto get_activations = [&](int64_t layer) -> const _Ty* {
+            if (layer < 0) {
+                return &eval_result.data[eval_result.inputs];
+            } else if (kept(layer)) {
+                return &eval_result.data[eval_result.layers[layer].activations];
+            } else {
+                return &result.data[result.layers[layer].activations];
+            }
+        };
+
+        auto get_z = [&](int64_t layer) -> const _Ty* {
+            if (kept(layer)) {
+                return &eval_result.data[eval_result.layers[layer].z];
+            } else {
+                return &result.data[result.layers[layer].z];
+            }
+        };
+
+        layer_sources_t sources;
+        if (interval > 0) {
+            sources = get_layer_sources(eval_result);
+        }
+
+        for (int64_t i = layers.size() - 1; i >= 0; i--) {
+            const auto& layer = layers[i];
+
+            // each block of passes runs through the whole segment. every layer of it has blocks
+            // of its own, so none overwrites rows another block has yet to read
+            int64_t segment_begin = interval > 0 && kept(i) ? i / interval * interval : i;
+            if (segment_begin < i) {
+                m_pool.parallel_for(passes, block_passes,
+                                    [&](size_t begin, size_t end, size_t thread_index) {
+                                        for (int64_t j = segment_begin; j < i; j++) {
+                                            const auto& offsets = result.layers[j];
+                                            _Ty* z = &result.data[offsets.z];
+                                            _Ty* activations = &result.data[offsets.activations];
+
+                                            multiply_layer(sources, eval_result, j,
+                                                           get_activations(j - 1), z, begin, end,
+                                                           0, layers[j].size, thread_index);
+
+                                            for (size_t pass = begin; pass < end; pass++) {
+                                                size_t offset = pass * layers[j].size;
+                                                A(*m_kernels, m_accuracy, layers[j].function,
+                                                  &z[offset], &activations[offset],
+                                                  layers[j].size);
+                                            }
+                                        }
+                                    });
+            }
+
+            auto activations = get_activations(i);
+            auto z = get_z(i);
+            auto previous_activations = get_activations(i - 1);
+
+            bool is_output = (size_t)i + 1 == layers.size();
+            _Ty* deltas = &result.data[result.layers[i].deltas];
+            const _Ty* next_deltas =
+                is_output ? nullptr : &result.data[result.layers[i + 1].deltas];
+
+            m_pool.parallel_for(passes, block_passes, [&](size_t begin, size_t end, size_t) {
+                // softmax and cross-entropy are differentiated together, straight to dC/dz
+                if (is_output && layer.function == activation_function::softmax) {
+                    for (size_t pass = begin; pass < end; pass++) {
+                        size_t offset = pass * layer.size;
+                        for (uint64_t c = 0; c < layer.size; c++) {
+                            deltas[offset + c] =
+                                activations[offset + c] - expected_outputs[offset + c];
+                        }
+                    }
+
+                    return;
+                }
+
+                // dC/da for every neuron on this layer
+                if (is_output) {
+                    for (size_t pass = begin; pass < end; pass++) {
+                        size_t offset = pass * layer.size;
+                        for (uint64_t c = 0; c < layer.size; c++) {
+                            deltas[offset + c] =
+                                dC_dx(activations[offset + c], expected_outputs[offset + c]);
+                        }
+                    }
+                } else {
+                    // the next layer's dC/dz times its weights, read through the transposed copy
+                    // so that every row of it is contiguous
+                    const auto& next_layer = layers[i + 1];
+                    dense_multiply(m_kernels->dot, next_deltas, transposed_weights[i + 1].data(),
+                                   (const _Ty*)nullptr, deltas, next_layer.size, layer.size,
+                                   begin, end, 0, layer.size);
+                }
+
+                for (size_t pass = begin; pass < end; pass++) {
+                    size_t offset = pass * layer.size;
+                    _Ty* dC_da = &deltas[offset];
+
+                    // in place: dC/dz = dC/da * da/dz
+                    dA_dz(*m_kernels, layer.function, &z[offset], &activations[offset], dC_da,
+                          layer.size);
+                }
+            });
+
+            auto bias_deltas = &result.data[result.layers[i].gradient];
+            auto weight_deltas = &bias_deltas[layer.size];
+
+            const auto& sparse_inputs = eval_result.sparse_inputs;
+            if (i == 0 && sparse_inputs.offsets != nullptr) {
+                // accumulated transposed, so that every non-zero input adds a contiguous row
+                auto transposed_gradient =
+                    result.memory.template allocate<_Ty>(layer.weights.size());
+
+                m_pool.parallel_for(layer.previous_size, block_rows,
+                                    [&](size_t begin, size_t end, size_t) {
+                                        sparse_gradient(*m_kernels, deltas, sparse_inputs,
+                                                        transposed_gradient, layer.size, passes,
+                                                        begin, end);
+
+                                        transpose(transposed_gradient, weight_deltas,
+                                                  layer.previous_size, layer.size, begin, end);
+                                    });
+
+                m_pool.parallel_for(layer.size, block_rows, [&](size_t begin, size_t end, size_t) {
+                    bias_gradient(deltas, bias_deltas, layer.size, passes, begin, end);
+                });
+            } else {
+                m_pool.parallel_for(layer.size, block_rows, [&](size_t begin, size_t end, size_t) {
+                    bias_gradient(deltas, bias_deltas, layer.size, passes, begin, end);
+                    dense_gradient(*m_kernels, deltas, previous_activations, layer, weight_deltas,
+                                   passes, begin, end);
+                });
+            }
+        }
+    }
+
+    template struct NN_API basic_cpu_workspace_t<float>;
+    template struct NN_API basic_cpu_workspace_t<double>;
+    template class NN_API basic_cpu_evaluator<float>;
+    template class NN_API basic_cpu_evaluator<double>;
 } // namespace neuralnet::evaluators
\ No newline at end of file
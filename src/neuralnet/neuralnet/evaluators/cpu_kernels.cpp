@@ -0,0 +1,413 @@
+#include "nnpch.h"
+#include "neuralnet/network.h"
+#include "neuralnet/evaluators/cpu_kernels.h"
+#include "neuralnet/precision.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define NN_X86
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+namespace neuralnet::evaluators {
+    template <typename _Ty>
+    static _Ty scalar_dot(const _Ty* a, const _Ty* b, size_t count) {
+        _Ty sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += a[i] * b[i];
+        }
+
+        return sum;
+    }
+
+    template <typename _Ty>
+    static _Ty scalar_dot_f16(const _Ty* a, const uint16_t* b, size_t count) {
+        _Ty sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += a[i] * from_half(b[i]);
+        }
+
+        return sum;
+    }
+
+    template <typename _Ty>
+    static _Ty scalar_dot_bf16(const _Ty* a, const uint16_t* b, size_t count) {
+        _Ty sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += a[i] * from_bfloat16(b[i]);
+        }
+
+        return sum;
+    }
+
+    template <typename _Ty>
+    static _Ty scalar_sparse_dot(const _Ty* values, const uint32_t* indices, const _Ty* x,
+                                 size_t count) {
+        _Ty sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += values[i] * x[indices[i]];
+        }
+
+        return sum;
+    }
+
+    template <typename _Ty>
+    static void scalar_sparse_dot_interleaved(const _Ty* values, const uint32_t* indices,
+                                              const _Ty* x, size_t count, _Ty* y, size_t width) {
+        std::fill(y, y + width, (_Ty)0);
+        for (size_t i = 0; i < count; i++) {
+            const _Ty* column = &x[indices[i] * width];
+            for (size_t j = 0; j < width; j++) {
+                y[j] += values[i] * column[j];
+            }
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_axpy(_Ty alpha, const _Ty* x, _Ty* y, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_sigmoid(const _Ty* x, _Ty* y, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            y[i] = 1 / (1 + std::exp(-x[i]));
+        }
+    }
+
+    // see simd_fast_exp. single precision at any _Ty; this tier is approximate either way
+    static float scalar_fast_exp(float x) {
+        x = std::clamp(x, -88.3762626647949f, 88.3762626647949f);
+
+        float n = std::nearbyint(x * 1.44269504088896341f);
+        x -= n * 0.693147180559945f;
+
+        float y = 0.16767011875f;
+        y = y * x + 0.50502228421f;
+        y = y * x + 0.99998492863f;
+        y = y * x + 0.99992455695f;
+
+        // 2^n through the exponent bits, as the vector path does
+        return y * std::bit_cast<float>(((int32_t)n + 127) << 23);
+    }
+
+    template <typename _Ty>
+    static void scalar_fast_sigmoid(const _Ty* x, _Ty* y, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            y[i] = 1 / (1 + (_Ty)scalar_fast_exp((float)-x[i]));
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_table_sigmoid(const _Ty* x, _Ty* y, size_t count) {
+        const number_t* table = kernels::get_sigmoid_table();
+        constexpr auto range = (_Ty)kernels::sigmoid_table_range;
+
+        for (size_t i = 0; i < count; i++) {
+            _Ty value = std::clamp(x[i], -range, range);
+            _Ty position = (value + range) * kernels::sigmoid_table_resolution;
+
+            auto index = (size_t)position;
+            _Ty t = position - (_Ty)index;
+
+            y[i] = table[index] + t * (table[index + 1] - table[index]);
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_sigmoid_gradient(const _Ty* a, _Ty* dy, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            dy[i] *= a[i] - a[i] * a[i];
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_relu(const _Ty* x, _Ty* y, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            y[i] = std::max(x[i], (_Ty)0);
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_leaky_relu(const _Ty* x, _Ty* y, size_t count, _Ty slope) {
+        for (size_t i = 0; i < count; i++) {
+            y[i] = std::max(x[i], x[i] * slope);
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_tanh(const _Ty* x, _Ty* y, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            y[i] = std::tanh(x[i]);
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_gelu(const _Ty* x, _Ty* y, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            y[i] = activate(activation_function::gelu, x[i]);
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_relu_gradient(const _Ty* a, _Ty* dy, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            dy[i] = a[i] > 0 ? dy[i] : 0;
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_leaky_relu_gradient(const _Ty* a, _Ty* dy, size_t count, _Ty slope) {
+        for (size_t i = 0; i < count; i++) {
+            dy[i] = a[i] > 0 ? dy[i] : dy[i] * slope;
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_tanh_gradient(const _Ty* a, _Ty* dy, size_t count) {
+        for (size_t i = 0; i < count; i++) {
+            dy[i] *= 1 - a[i] * a[i];
+        }
+    }
+
+    // see simd_gelu_gradient
+    template <typename _Ty>
+    static void scalar_gelu_gradient(const _Ty* z, _Ty* dy, size_t count) {
+        constexpr auto scale = (_Ty)gelu_scale;
+        constexpr auto cubic = (_Ty)gelu_cubic;
+
+        for (size_t i = 0; i < count; i++) {
+            _Ty square = z[i] * z[i];
+            _Ty s = 1 / (1 + std::exp(-scale * (z[i] + cubic * square * z[i])));
+            _Ty ds = (s - s * s) * scale * (1 + 3 * cubic * square);
+
+            dy[i] *= s + z[i] * ds;
+        }
+    }
+
+    template <typename _Ty>
+    static void scalar_softmax(const _Ty* x, _Ty* y, size_t count) {
+        if (x != y) {
+            std::copy(x, x + count, y);
+        }
+
+        if (count > 0) {
+            activate(activation_function::softmax, y, count);
+        }
+    }
+
+    static int32_t scalar_dot_i8(const int8_t* a, const int8_t* b, size_t count) {
+        int32_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += (int32_t)a[i] * (int32_t)b[i];
+        }
+
+        return sum;
+    }
+
+    template <typename _Ty>
+    static void scalar_quantize_i8(const _Ty* x, int8_t* q, size_t count, _Ty inverse_scale,
+                                   _Ty minimum) {
+        for (size_t i = 0; i < count; i++) {
+            _Ty value = std::clamp(x[i] * inverse_scale, minimum, (_Ty)127);
+            q[i] = (int8_t)std::nearbyint(value);
+        }
+    }
+
+    static int32_t scalar_dot_u8i8(const uint8_t* a, const int8_t* b, size_t count) {
+        int32_t sum = 0;
+        for (size_t i = 0; i < count; i++) {
+            sum += (int32_t)a[i] * (int32_t)b[i];
+        }
+
+        return sum;
+    }
+
+    template <typename _Ty>
+    static constexpr basic_cpu_kernels_t<_Ty> make_scalar_kernels() {
+        basic_cpu_kernels_t<_Ty> table{};
+        table.isa = cpu_isa::scalar;
+        table.dot = scalar_dot<_Ty>;
+        table.dot_f16 = scalar_dot_f16<_Ty>;
+        table.dot_bf16 = scalar_dot_bf16<_Ty>;
+        table.sparse_dot = scalar_sparse_dot<_Ty>;
+        table.sparse_dot_interleaved = scalar_sparse_dot_interleaved<_Ty>;
+        table.axpy = scalar_axpy<_Ty>;
+        table.sigmoid = scalar_sigmoid<_Ty>;
+        table.fast_sigmoid = scalar_fast_sigmoid<_Ty>;
+        table.table_sigmoid = scalar_table_sigmoid<_Ty>;
+        table.sigmoid_gradient = scalar_sigmoid_gradient<_Ty>;
+        table.relu = scalar_relu<_Ty>;
+        table.leaky_relu = scalar_leaky_relu<_Ty>;
+        table.tanh = scalar_tanh<_Ty>;
+        table.gelu = scalar_gelu<_Ty>;
+        table.relu_gradient = scalar_relu_gradient<_Ty>;
+        table.leaky_relu_gradient = scalar_leaky_relu_gradient<_Ty>;
+        table.tanh_gradient = scalar_tanh_gradient<_Ty>;
+        table.gelu_gradient = scalar_gelu_gradient<_Ty>;
+        table.softmax = scalar_softmax<_Ty>;
+        table.quantize_i8 = scalar_quantize_i8<_Ty>;
+        table.dot_i8 = scalar_dot_i8;
+        table.dot_u8i8 = scalar_dot_u8i8;
+
+        return table;
+    }
+
+    template <typename _Ty>
+    static constexpr basic_cpu_kernels_t<_Ty> s_scalar_kernels = make_scalar_kernels<_Ty>();
+
+    const number_t* kernels::get_sigmoid_table() {
+        static const auto table = []() {
+            std::array<number_t, kernels::sigmoid_table_size> samples;
+            for (size_t i = 0; i < samples.size() - 1; i++) {
+                double x = (double)i / kernels::sigmoid_table_resolution -
+                           (double)kernels::sigmoid_table_range;
+
+                samples[i] = (number_t)(1 / (1 + std::exp(-x)));
+            }
+
+            samples[samples.size() - 1] = samples[samples.size() - 2];
+            return samples;
+        }();
+
+        return table.data();
+    }
+
+    struct host_features_t {
+        bool sse42, avx2, avx512;
+    };
+
+    static host_features_t query_host_features() {
+        ZoneScoped;
+
+        host_features_t features;
+        features.sse42 = features.avx2 = features.avx512 = false;
+
+#if defined(NN_X86) && (defined(__GNUC__) || defined(__clang__))
+        // libgcc/compiler-rt also check that the os saves the wide registers
+        __builtin_cpu_init();
+        features.sse42 = __builtin_cpu_supports("sse4.2");
+        features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma") &&
+                        __builtin_cpu_supports("f16c");
+        features.avx512 = __builtin_cpu_supports("avx512f");
+#elif defined(NN_X86) && defined(_MSC_VER)
+        int info[4];
+        __cpuid(info, 0);
+        int max_leaf = info[0];
+
+        __cpuid(info, 1);
+        bool fma = (info[2] & (1 << 12)) != 0;
+        bool osxsave = (info[2] & (1 << 27)) != 0;
+        bool avx = (info[2] & (1 << 28)) != 0;
+        bool f16c = (info[2] & (1 << 29)) != 0;
+        features.sse42 = (info[2] & (1 << 20)) != 0;
+
+        bool avx2 = false, avx512f = false;
+        if (max_leaf >= 7) {
+            __cpuidex(info, 7, 0);
+            avx2 = (info[1] & (1 << 5)) != 0;
+            avx512f = (info[1] & (1 << 16)) != 0;
+        }
+
+        // the os needs to save ymm state, and opmask/zmm state for avx-512
+        uint64_t xcr0 = osxsave ? _xgetbv(0) : 0;
+        bool ymm_enabled = (xcr0 & 0x6) == 0x6;
+        bool zmm_enabled = (xcr0 & 0xE6) == 0xE6;
+
+        features.avx2 = avx && avx2 && fma && f16c && ymm_enabled;
+        features.avx512 = avx512f && zmm_enabled;
+#endif
+
+        return features;
+    }
+
+    static bool is_isa_supported(cpu_isa isa) {
+        static const host_features_t features = query_host_features();
+
+        switch (isa) {
+        case cpu_isa::scalar:
+            return true;
+        case cpu_isa::sse42:
+            return features.sse42;
+        case cpu_isa::avx2:
+            return features.avx2;
+        case cpu_isa::avx512:
+            return features.avx512;
+        default:
+            return false;
+        }
+    }
+
+    template <typename _Ty>
+    const basic_cpu_kernels_t<_Ty>* get_cpu_kernels(cpu_isa isa) {
+        ZoneScoped;
+
+        if (!is_isa_supported(isa)) {
+            return nullptr;
+        }
+
+        if (isa == cpu_isa::scalar) {
+            return &s_scalar_kernels<_Ty>;
+        }
+
+        // the vector kernels only come in single precision
+        if constexpr (std::is_same_v<_Ty, number_t>) {
+            switch (isa) {
+            case cpu_isa::sse42:
+                return kernels::get_sse42_kernels();
+            case cpu_isa::avx2:
+                return kernels::get_avx2_kernels();
+            case cpu_isa::avx512:
+                return kernels::get_avx512_kernels();
+            default:
+                break;
+            }
+        }
+
+        return nullptr;
+    }
+
+    template <typename _Ty>
+    const basic_cpu_kernels_t<_Ty>& get_cpu_kernels() {
+        ZoneScoped;
+
+        static const basic_cpu_kernels_t<_Ty>* best_kernels = []() {
+            static constexpr cpu_isa preference[] = { cpu_isa::avx512, cpu_isa::avx2,
+                                                      cpu_isa::sse42 };
+
+            for (cpu_isa isa : preference) {
+                auto kernels = get_cpu_kernels<_Ty>(isa);
+                if (kernels != nullptr) {
+                    return kernels;
+                }
+            }
+
+            return &s_scalar_kernels<_Ty>;
+        }();
+
+        return *best_kernels;
+    }
+
+    template NN_API const basic_cpu_kernels_t<float>& get_cpu_kernels<float>();
+    template NN_API const basic_cpu_kernels_t<double>& get_cpu_kernels<double>();
+    template NN_API const basic_cpu_kernels_t<float>* get_cpu_kernels<float>(cpu_isa isa);
+    template NN_API const basic_cpu_kernels_t<double>* get_cpu_kernels<double>(cpu_isa isa);
+
+    const char* get_cpu_isa_name(cpu_isa isa) {
+        switch (isa) {
+        case cpu_isa::scalar:
+            return "scalar";
+        case cpu_isa::sse42:
+            return "sse4.2";
+        case cpu_isa::avx2:
+            return "avx2";
+        case cpu_isa::avx512:
+            return "avx512";
+        default:
+            return "unknown";
+        }
+    }
+} // namespace neuralnet::evaluators
\ No newline at end of file
@@ -0,0 +1,121 @@
+#pragma once
+
+namespace neuralnet::evaluators {
+    // instruction sets the cpu evaluator has kernels for, in ascending order of preference
+    enum class cpu_isa { scalar, sse42, avx2, avx512 };
+
+    // accuracy tiers for transcendental activation functions. errors are absolute, measured on
+    // the function's output against a double precision reference
+    //   precise: cephes-style exp, within 2 ulp of expf. sigmoid is within 2e-7
+    //   fast: degree 3 exp polynomial. sigmoid is within 3e-5
+    //   table: linear interpolation in a 4097-entry table over [-16, 16]. sigmoid is within 1e-6
+    // only sigmoid has tiers; tanh and gelu always use the precise exp
+    enum class cpu_activation_accuracy { precise, fast, table };
+
+    // dense math used by cpu_evaluator, in precision _Ty
+    // every kernel accepts unaligned pointers and arbitrary counts
+    template <typename _Ty>
+    struct basic_cpu_kernels_t {
+        cpu_isa isa;
+
+        // returns the sum of a[i] * b[i]
+        _Ty (*dot)(const _Ty* a, const _Ty* b, size_t count);
+
+        // same as dot, with b stored as ieee binary16 or bfloat16 bits and widened as it is read.
+        // see parameter_format
+        _Ty (*dot_f16)(const _Ty* a, const uint16_t* b, size_t count);
+        _Ty (*dot_bf16)(const _Ty* a, const uint16_t* b, size_t count);
+
+        // returns the sum of values[i] * x[indices[i]], i.e. one row of a compressed sparse matrix
+        // times a dense vector
+        _Ty (*sparse_dot)(const _Ty* values, const uint32_t* indices, const _Ty* x, size_t count);
+
+        // sparse_dot against width vectors at once, stored interleaved (element p of vector j is
+        // x[p * width + j]). y[j] receives the sum for vector j
+        void (*sparse_dot_interleaved)(const _Ty* values, const uint32_t* indices, const _Ty* x,
+                                       size_t count, _Ty* y, size_t width);
+
+        // y[i] += alpha * x[i]
+        void (*axpy)(_Ty alpha, const _Ty* x, _Ty* y, size_t count);
+
+        // y[i] = 1 / (1 + e^(-x[i])) at each accuracy tier. x and y may alias
+        void (*sigmoid)(const _Ty* x, _Ty* y, size_t count);
+        void (*fast_sigmoid)(const _Ty* x, _Ty* y, size_t count);
+        void (*table_sigmoid)(const _Ty* x, _Ty* y, size_t count);
+
+        // dy[i] *= a[i] * (1 - a[i]), where a holds the outputs of the sigmoid
+        void (*sigmoid_gradient)(const _Ty* a, _Ty* dy, size_t count);
+
+        // y[i] = max(x[i], 0), and max(x[i], slope * x[i]) for slope within [0, 1). x and y may
+        // alias
+        void (*relu)(const _Ty* x, _Ty* y, size_t count);
+        void (*leaky_relu)(const _Ty* x, _Ty* y, size_t count, _Ty slope);
+
+        // y[i] = tanh(x[i]), within 2e-7. x and y may alias
+        void (*tanh)(const _Ty* x, _Ty* y, size_t count);
+
+        // y[i] = x[i] * sigmoid(gelu_scale * (x[i] + gelu_cubic * x[i]^3)), see activation_function
+        // x and y may alias
+        void (*gelu)(const _Ty* x, _Ty* y, size_t count);
+
+        // dy[i] *= da/dz, from the outputs a of relu, leaky_relu (with the same slope) and tanh
+        void (*relu_gradient)(const _Ty* a, _Ty* dy, size_t count);
+        void (*leaky_relu_gradient)(const _Ty* a, _Ty* dy, size_t count, _Ty slope);
+        void (*tanh_gradient)(const _Ty* a, _Ty* dy, size_t count);
+
+        // gelu cannot be differentiated from its outputs, so this takes its inputs z instead
+        void (*gelu_gradient)(const _Ty* z, _Ty* dy, size_t count);
+
+        // y[i] = e^x[i] / the sum of e^x[j] over all count elements, shifted by the largest x so
+        // that nothing overflows. x and y may alias
+        void (*softmax)(const _Ty* x, _Ty* y, size_t count);
+
+        // q[i] = round(x[i] * inverse_scale), clamped to [minimum, 127]
+        void (*quantize_i8)(const _Ty* x, int8_t* q, size_t count, _Ty inverse_scale,
+                            _Ty minimum);
+
+        // returns the sum of a[i] * b[i], accumulated in 32 bits
+        // every value must lie within [-127, 127]
+        int32_t (*dot_i8)(const int8_t* a, const int8_t* b, size_t count);
+
+        // same as dot_i8 for a within [0, 127], which skips the sign handling
+        int32_t (*dot_u8i8)(const uint8_t* a, const int8_t* b, size_t count);
+    };
+
+    using cpu_kernels_t = basic_cpu_kernels_t<number_t>;
+
+    // kernels for the best instruction set supported by the host, chosen on first call via cpuid
+    // vector kernels are single precision only; double precision always gets the scalar set
+    template <typename _Ty = number_t>
+    const basic_cpu_kernels_t<_Ty>& get_cpu_kernels();
+
+    // kernels for a specific instruction set. returns nullptr if either the host or the build
+    // does not support it
+    template <typename _Ty = number_t>
+    const basic_cpu_kernels_t<_Ty>* get_cpu_kernels(cpu_isa isa);
+
+    extern template NN_API const basic_cpu_kernels_t<float>& get_cpu_kernels<float>();
+    extern template NN_API const basic_cpu_kernels_t<double>& get_cpu_kernels<double>();
+    extern template NN_API const basic_cpu_kernels_t<float>* get_cpu_kernels<float>(cpu_isa isa);
+    extern template NN_API const basic_cpu_kernels_t<double>* get_cpu_kernels<double>(cpu_isa isa);
+
+    NN_API const char* get_cpu_isa_name(cpu_isa isa);
+
+    // per-instruction set tables, see cpu_kernels_*.cpp
+    // these return nullptr if the kernels were not compiled in
+    namespace kernels {
+        // sigmoid sampled every 1 / sigmoid_table_resolution over
+        // [-sigmoid_table_range, sigmoid_table_range], with the last sample repeated once so that
+        // interpolation never reads past the end
+        inline constexpr size_t sigmoid_table_range = 16;
+        inline constexpr size_t sigmoid_table_resolution = 128;
+        inline constexpr size_t sigmoid_table_size =
+            sigmoid_table_range * sigmoid_table_resolution * 2 + 2;
+
+        const number_t* get_sigmoid_table();
+
+        const cpu_kernels_t* get_sse42_kernels();
+        const cpu_kernels_t* get_avx2_kernels();
+        const cpu_kernels_t* get_avx512_kernels();
+    } // namespace kernels
+} // namespace neuralnet::evaluators
\ No newline at end of file
@@ -0,0 +1,144 @@
+#include "nnpch.h"
+#include "neuralnet/evaluators/cpu_kernels_simd.h"
+
+// compiled with avx512f enabled, see src/neuralnet/CMakeLists.txt
+#if defined(NN_SUPPORT_cpu) && defined(__AVX512F__)
+#define NN_KERNELS_AVAILABLE
+#include <immintrin.h>
+#endif
+
+namespace neuralnet::evaluators::kernels {
+#ifdef NN_KERNELS_AVAILABLE
+    namespace {
+        struct avx512_traits {
+            using type = __m512;
+            static constexpr size_t width = 16;
+
+            static type zero() { return _mm512_setzero_ps(); }
+            static type set1(float x) { return _mm512_set1_ps(x); }
+            static type load(const float* src) { return _mm512_loadu_ps(src); }
+            static void store(float* dst, type x) { _mm512_storeu_ps(dst, x); }
+
+            static type add(type a, type b) { return _mm512_add_ps(a, b); }
+            static type sub(type a, type b) { return _mm512_sub_ps(a, b); }
+            static type mul(type a, type b) { return _mm512_mul_ps(a, b); }
+            static type div(type a, type b) { return _mm512_div_ps(a, b); }
+            static type fmadd(type a, type b, type c) { return _mm512_fmadd_ps(a, b, c); }
+            static type min(type a, type b) { return _mm512_min_ps(a, b); }
+            static type max(type a, type b) { return _mm512_max_ps(a, b); }
+
+            static type select_positive(type x, type a, type b) {
+                __mmask16 positive = _mm512_cmp_ps_mask(x, _mm512_setzero_ps(), _CMP_GT_OQ);
+                return _mm512_mask_blend_ps(positive, b, a);
+            }
+
+            static type round(type x) {
+                return _mm512_roundscale_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            }
+
+            static type floor(type x) { return _mm512_floor_ps(x); }
+
+            static type gather(const float* table, type index) {
+                return _mm512_i32gather_ps(_mm512_cvttps_epi32(index), table, sizeof(float));
+            }
+
+            static type gather_indices(const float* table, const uint32_t* indices) {
+                __m512i index = _mm512_loadu_si512(indices);
+                return _mm512_i32gather_ps(index, table, sizeof(float));
+            }
+
+            static float reduce_add(type x) { return _mm512_reduce_add_ps(x); }
+
+            static type pow2(type n) {
+                __m512i exponent = _mm512_add_epi32(_mm512_cvtps_epi32(n), _mm512_set1_epi32(127));
+                return _mm512_castsi512_ps(_mm512_slli_epi32(exponent, 23));
+            }
+
+            static type load_f16(const uint16_t* src) {
+                return _mm512_cvtph_ps(_mm256_loadu_si256((const __m256i*)src));
+            }
+
+            static type load_bf16(const uint16_t* src) {
+                __m512i bits = _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i*)src));
+                return _mm512_castsi512_ps(_mm512_slli_epi32(bits, 16));
+            }
+
+            // byte arithmetic needs avx-512bw, so this sticks to the avx2 version
+            // |a| * (b with the sign of a) keeps the product while giving maddubs the unsigned
+            // operand it needs. pairs sum to at most 2 * 127 * 127, so the 16-bit step never
+            // saturates
+            static int32_t dot_i8(const int8_t* a, const int8_t* b, size_t count) {
+                __m256i sum = _mm256_setzero_si256();
+                __m256i ones = _mm256_set1_epi16(1);
+
+                size_t i = 0;
+                for (; i + 32 <= count; i += 32) {
+                    __m256i va = _mm256_loadu_si256((const __m256i*)&a[i]);
+                    __m256i vb = _mm256_loadu_si256((const __m256i*)&b[i]);
+
+                    __m256i products =
+                        _mm256_maddubs_epi16(_mm256_sign_epi8(va, va), _mm256_sign_epi8(vb, va));
+
+                    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+                }
+
+                __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                             _mm256_extracti128_si256(sum, 1));
+
+                half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+                half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+
+                int32_t result = _mm_cvtsi128_si32(half);
+                for (; i < count; i++) {
+                    result += (int32_t)a[i] * (int32_t)b[i];
+                }
+
+                return result;
+            }
+
+            static int32_t dot_u8i8(const uint8_t* a, const int8_t* b, size_t count) {
+                __m256i sum = _mm256_setzero_si256();
+                __m256i ones = _mm256_set1_epi16(1);
+
+                size_t i = 0;
+                for (; i + 32 <= count; i += 32) {
+                    __m256i va = _mm256_loadu_si256((const __m256i*)&a[i]);
+                    __m256i vb = _mm256_loadu_si256((const __m256i*)&b[i]);
+
+                    __m256i products = _mm256_maddubs_epi16(va, vb);
+                    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+                }
+
+                __m128i half = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                             _mm256_extracti128_si256(sum, 1));
+
+                // one more 16-byte step before falling back to scalar code
+                if (i + 16 <= count) {
+                    __m128i va = _mm_loadu_si128((const __m128i*)&a[i]);
+                    __m128i vb = _mm_loadu_si128((const __m128i*)&b[i]);
+
+                    __m128i products = _mm_maddubs_epi16(va, vb);
+                    half = _mm_add_epi32(half, _mm_madd_epi16(products, _mm_set1_epi16(1)));
+                    i += 16;
+                }
+
+                half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(1, 0, 3, 2)));
+                half = _mm_add_epi32(half, _mm_shuffle_epi32(half, _MM_SHUFFLE(2, 3, 0, 1)));
+
+                int32_t result = _mm_cvtsi128_si32(half);
+                for (; i < count; i++) {
+                    result += (int32_t)a[i] * (int32_t)b[i];
+                }
+
+                return result;
+            }
+        };
+
+        constexpr cpu_kernels_t s_kernels = make_simd_kernels<avx512_traits>(cpu_isa::avx512);
+    } // namespace
+
+    const cpu_kernels_t* get_avx512_kernels() { return &s_kernels; }
+#else
+    const cpu_kernels_t* get_avx512_kernels() { return nullptr; }
+#endif
+} // namespace neuralnet::evaluators::kernels
\ No newline at end of file
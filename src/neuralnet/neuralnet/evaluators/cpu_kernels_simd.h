@@ -0,0 +1,512 @@
+#pragma once
+#include "neuralnet/network.h"
+#include "neuralnet/evaluators/cpu_kernels.h"
+
+// generic kernel bodies, instantiated once per instruction set by cpu_kernels_*.cpp
+// those translation units are compiled with instruction set flags, so nothing in here may call into
+// inline library code (std::exp, std::min, etc.) - the linker could otherwise pick the wide copy
+// for the rest of the program
+//
+// an instruction set is described by a traits type V, which provides:
+//   type, width
+//   zero, set1, load, store
+//   add, sub, mul, div, fmadd (a * b + c), min, max
+//   select_positive (a where x > 0, b elsewhere)
+//   round (to nearest), floor, reduce_add, pow2 (2^n for integral-valued n)
+//   gather (table[i] for every non-negative, integral-valued i)
+//   gather_indices (table[indices[j]] for the width indices starting at indices)
+//   load_f16, load_bf16 (width 16-bit values widened to floats)
+//   dot_i8, dot_u8i8 (whole int8 dot product kernels; integer math does not map onto the
+//   primitives above)
+
+namespace neuralnet::evaluators::kernels {
+    template <typename V>
+    inline number_t simd_dot(const number_t* a, const number_t* b, size_t count) {
+        constexpr size_t width = V::width;
+
+        // two accumulators to hide fma latency
+        auto sum0 = V::zero();
+        auto sum1 = V::zero();
+
+        size_t i = 0;
+        for (; i + width * 2 <= count; i += width * 2) {
+            sum0 = V::fmadd(V::load(&a[i]), V::load(&b[i]), sum0);
+            sum1 = V::fmadd(V::load(&a[i + width]), V::load(&b[i + width]), sum1);
+        }
+
+        for (; i + width <= count; i += width) {
+            sum0 = V::fmadd(V::load(&a[i]), V::load(&b[i]), sum0);
+        }
+
+        number_t sum = V::reduce_add(V::add(sum0, sum1));
+        for (; i < count; i++) {
+            sum += a[i] * b[i];
+        }
+
+        return sum;
+    }
+
+    // simd_dot with b widened from 16 bits by load
+    template <typename V, typename L>
+    inline number_t simd_dot_widened(const number_t* a, const uint16_t* b, size_t count,
+                                     const L& load) {
+        constexpr size_t width = V::width;
+
+        auto sum0 = V::zero();
+        auto sum1 = V::zero();
+
+        size_t i = 0;
+        for (; i + width * 2 <= count; i += width * 2) {
+            sum0 = V::fmadd(V::load(&a[i]), load(&b[i]), sum0);
+            sum1 = V::fmadd(V::load(&a[i + width]), load(&b[i + width]), sum1);
+        }
+
+        for (; i + width <= count; i += width) {
+            sum0 = V::fmadd(V::load(&a[i]), load(&b[i]), sum0);
+        }
+
+        // zero-padded remainder, so that no scalar conversion is needed
+        if (i < count) {
+            number_t tail_a[width];
+            uint16_t tail_b[width];
+
+            for (size_t j = 0; j < width; j++) {
+                tail_a[j] = i + j < count ? a[i + j] : 0;
+                tail_b[j] = i + j < count ? b[i + j] : 0;
+            }
+
+            sum1 = V::fmadd(V::load(tail_a), load(tail_b), sum1);
+        }
+
+        return V::reduce_add(V::add(sum0, sum1));
+    }
+
+    template <typename V>
+    inline number_t simd_dot_f16(const number_t* a, const uint16_t* b, size_t count) {
+        return simd_dot_widened<V>(a, b, count, V::load_f16);
+    }
+
+    template <typename V>
+    inline number_t simd_dot_bf16(const number_t* a, const uint16_t* b, size_t count) {
+        return simd_dot_widened<V>(a, b, count, V::load_bf16);
+    }
+
+    template <typename V>
+    inline number_t simd_sparse_dot(const number_t* values, const uint32_t* indices,
+                                    const number_t* x, size_t count) {
+        constexpr size_t width = V::width;
+
+        // gathers are slow to issue, so two are kept in flight
+        auto sum0 = V::zero();
+        auto sum1 = V::zero();
+
+        size_t i = 0;
+        for (; i + width * 2 <= count; i += width * 2) {
+            sum0 = V::fmadd(V::load(&values[i]), V::gather_indices(x, &indices[i]), sum0);
+            sum1 = V::fmadd(V::load(&values[i + width]), V::gather_indices(x, &indices[i + width]),
+                            sum1);
+        }
+
+        for (; i + width <= count; i += width) {
+            sum0 = V::fmadd(V::load(&values[i]), V::gather_indices(x, &indices[i]), sum0);
+        }
+
+        number_t sum = V::reduce_add(V::add(sum0, sum1));
+        for (; i < count; i++) {
+            sum += values[i] * x[indices[i]];
+        }
+
+        return sum;
+    }
+
+    template <typename V>
+    inline void simd_sparse_dot_interleaved(const number_t* values, const uint32_t* indices,
+                                            const number_t* x, size_t count, number_t* y,
+                                            size_t width) {
+        constexpr size_t vector_width = V::width;
+
+        // every entry is broadcast once and multiplied against contiguous vectors, so no gathers
+        // are needed. the sums stay in registers across the whole row
+        size_t j = 0;
+        for (; j + vector_width * 2 <= width; j += vector_width * 2) {
+            auto sum0 = V::zero();
+            auto sum1 = V::zero();
+
+            for (size_t i = 0; i < count; i++) {
+                auto value = V::set1(values[i]);
+                const number_t* column = &x[indices[i] * width + j];
+
+                sum0 = V::fmadd(value, V::load(column), sum0);
+                sum1 = V::fmadd(value, V::load(&column[vector_width]), sum1);
+            }
+
+            V::store(&y[j], sum0);
+            V::store(&y[j + vector_width], sum1);
+        }
+
+        for (; j + vector_width <= width; j += vector_width) {
+            auto sum = V::zero();
+            for (size_t i = 0; i < count; i++) {
+                sum = V::fmadd(V::set1(values[i]), V::load(&x[indices[i] * width + j]), sum);
+            }
+
+            V::store(&y[j], sum);
+        }
+
+        for (; j < width; j++) {
+            number_t sum = 0;
+            for (size_t i = 0; i < count; i++) {
+                sum += values[i] * x[indices[i] * width + j];
+            }
+
+            y[j] = sum;
+        }
+    }
+
+    template <typename V>
+    inline void simd_axpy(number_t alpha, const number_t* x, number_t* y, size_t count) {
+        constexpr size_t width = V::width;
+        auto alpha_vector = V::set1(alpha);
+
+        size_t i = 0;
+        for (; i + width <= count; i += width) {
+            V::store(&y[i], V::fmadd(alpha_vector, V::load(&x[i]), V::load(&y[i])));
+        }
+
+        for (; i < count; i++) {
+            y[i] += alpha * x[i];
+        }
+    }
+
+    // cephes-style single precision exp: range reduction to [-ln2/2, ln2/2], a degree 5
+    // polynomial, then scaling by 2^n through the exponent bits
+    // relative error is within 2 ulp over the clamped range
+    template <typename V>
+    inline typename V::type simd_exp(typename V::type x) {
+        x = V::min(x, V::set1(88.3762626647949f));
+        x = V::max(x, V::set1(-88.3762626647949f));
+
+        auto n = V::round(V::mul(x, V::set1(1.44269504088896341f)));
+        x = V::fmadd(n, V::set1(-0.693359375f), x);
+        x = V::fmadd(n, V::set1(2.12194440e-4f), x);
+
+        auto y = V::set1(1.9875691500e-4f);
+        y = V::fmadd(y, x, V::set1(1.3981999507e-3f));
+        y = V::fmadd(y, x, V::set1(8.3334519073e-3f));
+        y = V::fmadd(y, x, V::set1(4.1665795894e-2f));
+        y = V::fmadd(y, x, V::set1(1.6666665459e-1f));
+        y = V::fmadd(y, x, V::set1(5.0000001201e-1f));
+        y = V::fmadd(y, V::mul(x, x), V::add(x, V::set1(1.f)));
+
+        return V::mul(y, V::pow2(n));
+    }
+
+    // same range reduction, with a degree 3 polynomial (chebyshev interpolant of e^x over
+    // [-ln2/2, ln2/2]) in place of the degree 5 one
+    // relative error is within 1e-4
+    template <typename V>
+    inline typename V::type simd_fast_exp(typename V::type x) {
+        x = V::min(x, V::set1(88.3762626647949f));
+        x = V::max(x, V::set1(-88.3762626647949f));
+
+        auto n = V::round(V::mul(x, V::set1(1.44269504088896341f)));
+        x = V::fmadd(n, V::set1(-0.693147180559945f), x);
+
+        auto y = V::set1(0.16767011875f);
+        y = V::fmadd(y, x, V::set1(0.50502228421f));
+        y = V::fmadd(y, x, V::set1(0.99998492863f));
+        y = V::fmadd(y, x, V::set1(0.99992455695f));
+
+        return V::mul(y, V::pow2(n));
+    }
+
+    // applies a vector function to every element
+    template <typename V, typename F>
+    inline void simd_map(const number_t* x, number_t* y, size_t count, const F& func) {
+        constexpr size_t width = V::width;
+
+        size_t i = 0;
+        for (; i + width <= count; i += width) {
+            V::store(&y[i], func(V::load(&x[i])));
+        }
+
+        // run the remainder through the vector path as well, so that every element gets the
+        // same rounding
+        if (i < count) {
+            number_t tail[width];
+            for (size_t j = 0; j < width; j++) {
+                tail[j] = i + j < count ? x[i + j] : 0;
+            }
+
+            V::store(tail, func(V::load(tail)));
+            for (size_t j = 0; i + j < count; j++) {
+                y[i + j] = tail[j];
+            }
+        }
+    }
+
+    template <typename V>
+    inline void simd_sigmoid(const number_t* x, number_t* y, size_t count) {
+        auto one = V::set1(1.f);
+        simd_map<V>(x, y, count, [&](typename V::type value) {
+            auto e = simd_exp<V>(V::sub(V::zero(), value));
+            return V::div(one, V::add(one, e));
+        });
+    }
+
+    template <typename V>
+    inline void simd_fast_sigmoid(const number_t* x, number_t* y, size_t count) {
+        auto one = V::set1(1.f);
+        simd_map<V>(x, y, count, [&](typename V::type value) {
+            auto e = simd_fast_exp<V>(V::sub(V::zero(), value));
+            return V::div(one, V::add(one, e));
+        });
+    }
+
+    template <typename V>
+    inline void simd_table_sigmoid(const number_t* x, number_t* y, size_t count) {
+        const number_t* table = get_sigmoid_table();
+
+        auto range = V::set1((number_t)sigmoid_table_range);
+        auto resolution = V::set1((number_t)sigmoid_table_resolution);
+
+        simd_map<V>(x, y, count, [&](typename V::type value) {
+            value = V::min(value, range);
+            value = V::max(value, V::sub(V::zero(), range));
+
+            auto position = V::mul(V::add(value, range), resolution);
+            auto index = V::floor(position);
+            auto t = V::sub(position, index);
+
+            auto a = V::gather(table, index);
+            auto b = V::gather(&table[1], index);
+
+            return V::fmadd(t, V::sub(b, a), a);
+        });
+    }
+
+    template <typename V>
+    inline void simd_sigmoid_gradient(const number_t* a, number_t* dy, size_t count) {
+        constexpr size_t width = V::width;
+
+        size_t i = 0;
+        for (; i + width <= count; i += width) {
+            auto activation = V::load(&a[i]);
+            auto derivative = V::sub(activation, V::mul(activation, activation));
+
+            V::store(&dy[i], V::mul(V::load(&dy[i]), derivative));
+        }
+
+        for (; i < count; i++) {
+            dy[i] *= a[i] - a[i] * a[i];
+        }
+    }
+
+    template <typename V>
+    inline void simd_relu(const number_t* x, number_t* y, size_t count) {
+        simd_map<V>(x, y, count, [](typename V::type value) { return V::max(value, V::zero()); });
+    }
+
+    template <typename V>
+    inline void simd_leaky_relu(const number_t* x, number_t* y, size_t count, number_t slope) {
+        auto slope_vector = V::set1(slope);
+        simd_map<V>(x, y, count, [&](typename V::type value) {
+            return V::max(value, V::mul(value, slope_vector));
+        });
+    }
+
+    // 1 - 2 / (1 + e^2x). simd_exp clamps its argument, so large magnitudes saturate at +-1
+    template <typename V>
+    inline void simd_tanh(const number_t* x, number_t* y, size_t count) {
+        auto one = V::set1(1.f);
+        auto two = V::set1(2.f);
+
+        simd_map<V>(x, y, count, [&](typename V::type value) {
+            auto e = simd_exp<V>(V::mul(value, two));
+            return V::sub(one, V::div(two, V::add(one, e)));
+        });
+    }
+
+    template <typename V>
+    inline void simd_gelu(const number_t* x, number_t* y, size_t count) {
+        auto one = V::set1(1.f);
+        auto scale = V::set1((number_t)-gelu_scale);
+        auto cubic = V::set1((number_t)gelu_cubic);
+
+        simd_map<V>(x, y, count, [&](typename V::type value) {
+            auto cube = V::mul(V::mul(value, value), value);
+            auto e = simd_exp<V>(V::mul(scale, V::fmadd(cubic, cube, value)));
+
+            return V::div(value, V::add(one, e));
+        });
+    }
+
+    // applies func(a, dy) to every element of dy, in place
+    template <typename V, typename F>
+    inline void simd_scale_gradient(const number_t* a, number_t* dy, size_t count,
+                                    const F& func) {
+        constexpr size_t width = V::width;
+
+        size_t i = 0;
+        for (; i + width <= count; i += width) {
+            V::store(&dy[i], func(V::load(&a[i]), V::load(&dy[i])));
+        }
+
+        if (i < count) {
+            number_t tail_a[width], tail_dy[width];
+            for (size_t j = 0; j < width; j++) {
+                tail_a[j] = i + j < count ? a[i + j] : 0;
+                tail_dy[j] = i + j < count ? dy[i + j] : 0;
+            }
+
+            V::store(tail_dy, func(V::load(tail_a), V::load(tail_dy)));
+            for (size_t j = 0; i + j < count; j++) {
+                dy[i + j] = tail_dy[j];
+            }
+        }
+    }
+
+    template <typename V>
+    inline void simd_relu_gradient(const number_t* a, number_t* dy, size_t count) {
+        simd_scale_gradient<V>(a, dy, count, [](typename V::type activation, typename V::type d) {
+            return V::select_positive(activation, d, V::zero());
+        });
+    }
+
+    template <typename V>
+    inline void simd_leaky_relu_gradient(const number_t* a, number_t* dy, size_t count,
+                                         number_t slope) {
+        auto slope_vector = V::set1(slope);
+        simd_scale_gradient<V>(a, dy, count, [&](typename V::type activation, typename V::type d) {
+            return V::select_positive(activation, d, V::mul(d, slope_vector));
+        });
+    }
+
+    template <typename V>
+    inline void simd_tanh_gradient(const number_t* a, number_t* dy, size_t count) {
+        auto one = V::set1(1.f);
+        simd_scale_gradient<V>(a, dy, count, [&](typename V::type activation, typename V::type d) {
+            return V::mul(d, V::sub(one, V::mul(activation, activation)));
+        });
+    }
+
+    // with s = sigmoid(u) and u = gelu_scale * (z + gelu_cubic * z^3),
+    // d/dz z * s = s + z * s * (1 - s) * gelu_scale * (1 + 3 * gelu_cubic * z^2)
+    template <typename V>
+    inline void simd_gelu_gradient(const number_t* z, number_t* dy, size_t count) {
+        auto one = V::set1(1.f);
+        auto scale = V::set1((number_t)gelu_scale);
+        auto cubic = V::set1((number_t)gelu_cubic);
+        auto cubic3 = V::set1((number_t)(gelu_cubic * 3));
+
+        simd_scale_gradient<V>(z, dy, count, [&](typename V::type value, typename V::type d) {
+            auto square = V::mul(value, value);
+            auto u = V::mul(scale, V::fmadd(cubic, V::mul(square, value), value));
+            auto s = V::div(one, V::add(one, simd_exp<V>(V::sub(V::zero(), u))));
+
+            auto du = V::mul(scale, V::fmadd(cubic3, square, one));
+            auto ds = V::mul(V::sub(s, V::mul(s, s)), du);
+
+            return V::mul(d, V::fmadd(value, ds, s));
+        });
+    }
+
+    template <typename V>
+    inline void simd_softmax(const number_t* x, number_t* y, size_t count) {
+        constexpr size_t width = V::width;
+        if (count == 0) {
+            return;
+        }
+
+        number_t maximum = x[0];
+        for (size_t i = 1; i < count; i++) {
+            maximum = x[i] > maximum ? x[i] : maximum;
+        }
+
+        auto shift = V::set1(maximum);
+        simd_map<V>(x, y, count,
+                    [&](typename V::type value) { return simd_exp<V>(V::sub(value, shift)); });
+
+        auto sum_vector = V::zero();
+        size_t i = 0;
+
+        for (; i + width <= count; i += width) {
+            sum_vector = V::add(sum_vector, V::load(&y[i]));
+        }
+
+        number_t sum = V::reduce_add(sum_vector);
+        for (; i < count; i++) {
+            sum += y[i];
+        }
+
+        auto scale = V::set1(1.f / sum);
+        simd_map<V>(y, y, count, [&](typename V::type value) { return V::mul(value, scale); });
+    }
+
+    template <typename V>
+    inline void simd_quantize_i8(const number_t* x, int8_t* q, size_t count,
+                                 number_t inverse_scale, number_t minimum) {
+        constexpr size_t width = V::width;
+
+        auto scale_vector = V::set1(inverse_scale);
+        auto min_vector = V::set1(minimum);
+        auto max_vector = V::set1(127.f);
+
+        // rounded in vectors, narrowed one element at a time. the values are already integral
+        number_t rounded[width];
+        for (size_t i = 0; i < count; i += width) {
+            size_t chunk = count - i < width ? count - i : width;
+
+            typename V::type value;
+            if (chunk == width) {
+                value = V::load(&x[i]);
+            } else {
+                for (size_t j = 0; j < width; j++) {
+                    rounded[j] = j < chunk ? x[i + j] : 0;
+                }
+
+                value = V::load(rounded);
+            }
+
+            value = V::mul(value, scale_vector);
+            value = V::min(V::max(value, min_vector), max_vector);
+            V::store(rounded, V::round(value));
+
+            for (size_t j = 0; j < chunk; j++) {
+                q[i + j] = (int8_t)rounded[j];
+            }
+        }
+    }
+
+    // constexpr so that the per-instruction set tables are constant-initialized; no code compiled
+    // with instruction set flags runs before the host has been checked
+    template <typename V>
+    constexpr cpu_kernels_t make_simd_kernels(cpu_isa isa) {
+        cpu_kernels_t table{};
+        table.isa = isa;
+        table.dot = simd_dot<V>;
+        table.dot_f16 = simd_dot_f16<V>;
+        table.dot_bf16 = simd_dot_bf16<V>;
+        table.sparse_dot = simd_sparse_dot<V>;
+        table.sparse_dot_interleaved = simd_sparse_dot_interleaved<V>;
+        table.axpy = simd_axpy<V>;
+        table.sigmoid = simd_sigmoid<V>;
+        table.fast_sigmoid = simd_fast_sigmoid<V>;
+        table.table_sigmoid = simd_table_sigmoid<V>;
+        table.sigmoid_gradient = simd_sigmoid_gradient<V>;
+        table.relu = simd_relu<V>;
+        table.leaky_relu = simd_leaky_relu<V>;
+        table.tanh = simd_tanh<V>;
+        table.gelu = simd_gelu<V>;
+        table.relu_gradient = simd_relu_gradient<V>;
+        table.leaky_relu_gradient = simd_leaky_relu_gradient<V>;
+        table.tanh_gradient = simd_tanh_gradient<V>;
+        table.gelu_gradient = simd_gelu_gradient<V>;
+        table.softmax = simd_softmax<V>;
+        table.quantize_i8 = simd_quantize_i8<V>;
+        table.dot_i8 = V::dot_i8;
+        table.dot_u8i8 = V::dot_u8i8;
+
+        return table;
+    }
+} // namespace neuralnet::evaluators::kernels
\ No newline at end of file
@@ -0,0 +1,152 @@
+#include "nnpch.h"
+#include "neuralnet/evaluators/cpu_kernels_simd.h"
+
+// compiled with sse4.2 enabled, see src/neuralnet/CMakeLists.txt
+#if defined(NN_SUPPORT_cpu) && (defined(__SSE4_2__) || (defined(_MSC_VER) && defined(_M_X64)))
+#define NN_KERNELS_AVAILABLE
+#include <immintrin.h>
+#endif
+
+namespace neuralnet::evaluators::kernels {
+#ifdef NN_KERNELS_AVAILABLE
+    namespace {
+        struct sse42_traits {
+            using type = __m128;
+            static constexpr size_t width = 4;
+
+            static type zero() { return _mm_setzero_ps(); }
+            static type set1(float x) { return _mm_set1_ps(x); }
+            static type load(const float* src) { return _mm_loadu_ps(src); }
+            static void store(float* dst, type x) { _mm_storeu_ps(dst, x); }
+
+            static type add(type a, type b) { return _mm_add_ps(a, b); }
+            static type sub(type a, type b) { return _mm_sub_ps(a, b); }
+            static type mul(type a, type b) { return _mm_mul_ps(a, b); }
+            static type div(type a, type b) { return _mm_div_ps(a, b); }
+            static type fmadd(type a, type b, type c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+            static type min(type a, type b) { return _mm_min_ps(a, b); }
+            static type max(type a, type b) { return _mm_max_ps(a, b); }
+
+            static type select_positive(type x, type a, type b) {
+                return _mm_blendv_ps(b, a, _mm_cmpgt_ps(x, _mm_setzero_ps()));
+            }
+
+            static type round(type x) {
+                return _mm_round_ps(x, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+            }
+
+            static type floor(type x) { return _mm_floor_ps(x); }
+
+            // no gather instruction before avx2
+            static type gather(const float* table, type index) {
+                alignas(16) int32_t indices[4];
+                _mm_store_si128((__m128i*)indices, _mm_cvttps_epi32(index));
+
+                return _mm_setr_ps(table[indices[0]], table[indices[1]], table[indices[2]],
+                                   table[indices[3]]);
+            }
+
+            static type gather_indices(const float* table, const uint32_t* indices) {
+                return _mm_setr_ps(table[indices[0]], table[indices[1]], table[indices[2]],
+                                   table[indices[3]]);
+            }
+
+            static float reduce_add(type x) {
+                type shuffled = _mm_movehdup_ps(x);
+                type sums = _mm_add_ps(x, shuffled);
+
+                shuffled = _mm_movehl_ps(shuffled, sums);
+                sums = _mm_add_ss(sums, shuffled);
+
+                return _mm_cvtss_f32(sums);
+            }
+
+            static type pow2(type n) {
+                __m128i exponent = _mm_add_epi32(_mm_cvtps_epi32(n), _mm_set1_epi32(127));
+                return _mm_castsi128_ps(_mm_slli_epi32(exponent, 23));
+            }
+
+            static __m128i load_u16(const uint16_t* src) {
+                return _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i*)src));
+            }
+
+            // no f16c before avx: see from_half, which this mirrors
+            static type load_f16(const uint16_t* src) {
+                __m128i bits = load_u16(src);
+                __m128i magnitude = _mm_and_si128(bits, _mm_set1_epi32(0x7FFF));
+
+                type value = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(magnitude, 13)),
+                                        _mm_castsi128_ps(_mm_set1_epi32(0x77800000)));
+
+                __m128i special = _mm_cmpgt_epi32(magnitude, _mm_set1_epi32(0x7BFF));
+                __m128i exponent = _mm_and_si128(special, _mm_set1_epi32(0x7F800000));
+                __m128i sign = _mm_slli_epi32(_mm_and_si128(bits, _mm_set1_epi32(0x8000)), 16);
+
+                return _mm_or_ps(value, _mm_castsi128_ps(_mm_or_si128(exponent, sign)));
+            }
+
+            static type load_bf16(const uint16_t* src) {
+                return _mm_castsi128_ps(_mm_slli_epi32(load_u16(src), 16));
+            }
+
+            // |a| * (b with the sign of a) keeps the product while giving maddubs the unsigned
+            // operand it needs. pairs sum to at most 2 * 127 * 127, so the 16-bit step never
+            // saturates
+            static int32_t dot_i8(const int8_t* a, const int8_t* b, size_t count) {
+                __m128i sum = _mm_setzero_si128();
+                __m128i ones = _mm_set1_epi16(1);
+
+                size_t i = 0;
+                for (; i + 16 <= count; i += 16) {
+                    __m128i va = _mm_loadu_si128((const __m128i*)&a[i]);
+                    __m128i vb = _mm_loadu_si128((const __m128i*)&b[i]);
+
+                    __m128i products =
+                        _mm_maddubs_epi16(_mm_sign_epi8(va, va), _mm_sign_epi8(vb, va));
+
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(products, ones));
+                }
+
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+                int32_t result = _mm_cvtsi128_si32(sum);
+                for (; i < count; i++) {
+                    result += (int32_t)a[i] * (int32_t)b[i];
+                }
+
+                return result;
+            }
+
+            static int32_t dot_u8i8(const uint8_t* a, const int8_t* b, size_t count) {
+                __m128i sum = _mm_setzero_si128();
+                __m128i ones = _mm_set1_epi16(1);
+
+                size_t i = 0;
+                for (; i + 16 <= count; i += 16) {
+                    __m128i va = _mm_loadu_si128((const __m128i*)&a[i]);
+                    __m128i vb = _mm_loadu_si128((const __m128i*)&b[i]);
+
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(_mm_maddubs_epi16(va, vb), ones));
+                }
+
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+
+                int32_t result = _mm_cvtsi128_si32(sum);
+                for (; i < count; i++) {
+                    result += (int32_t)a[i] * (int32_t)b[i];
+                }
+
+                return result;
+            }
+        };
+
+        constexpr cpu_kernels_t s_kernels = make_simd_kernels<sse42_traits>(cpu_isa::sse42);
+    } // namespace
+
+    const cpu_kernels_t* get_sse42_kernels() { return &s_kernels; }
+#else
+    const cpu_kernels_t* get_sse42_kernels() { return nullptr; }
+#endif
+} // namespace neuralnet::evaluators::kernels
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 #include "neuralnet/evaluator.h"
+#include "neuralnet/precision.h"
 
 #ifdef NN_SUPPORT_vulkan
 #define VK_NO_PROTOTYPES
@@ -12,55 +13,384 @@
 #define NN_DECLARE_VK_FUNCTION(name) PFN_##name name
 #endif
 
+#ifdef NN_SUPPORT_cpu
+#include "neuralnet/evaluators/cpu_kernels.h"
+#include "neuralnet/thread_pool.h"
+#include "neuralnet/arena.h"
+#include "neuralnet/quantization.h"
+#include "neuralnet/sparsity.h"
+#include "neuralnet/factorization.h"
+#endif
+
 namespace neuralnet::evaluators {
 #ifdef NN_SUPPORT_cpu
     enum class cpu_result_type { eval, backprop };
 
-    struct cpu_result_t {
-        cpu_result_type type;
-        const network* nn;
+    // offsets into cpu_result_t::data, in elements
+    // per-pass blocks are laid out pass-major (passes x size)
+    struct cpu_layer_offsets_t {
+        // eval: activations and pre-activations of every pass
+        // evaluations outside of training only store the output layer's activations, and
+        // checkpointed ones only those of checkpoint layers, see set_checkpoint_interval
+        // backprop: with checkpointing, those of the layers the evaluation did not keep,
+        // recomputed a segment at a time. segments share memory
+        size_t activations, z;
+
+        // backprop: dC/dz of every pass, and the gradient summed over the batch (biases, then
+        // weights). with checkpointing, layers alternate between two blocks of deltas
+        size_t deltas, gradient;
+    };
 
-        // for eval, this vector would contain the inputs for the first element
-        // after the first element, each pointer contains activations, and then pre-activations
-        // for backprop, this vector contains deltas to apply to the neural network, typed layer_t
-        std::vector<void*> results;
+    // inputs compressed to their non-zero entries
+    // pass p owns entries [offsets[p], offsets[p + 1]) of indices and values
+    template <typename _Ty>
+    struct basic_cpu_sparse_inputs_t {
+        uint32_t* offsets;
+        uint32_t* indices;
+        _Ty* values;
+    };
+
+    // everything about evaluating a network in batches of a given size that does not depend on
+    // the inputs, worked out once by cpu_evaluator and shared by every result of that shape
+    template <typename _Ty>
+    struct basic_cpu_execution_plan_t {
+        const basic_network<_Ty>* nn;
         size_t passes;
+        bool training;
+
+        // 0 if training evaluations keep every layer
+        size_t checkpoint_interval;
+
+        // block layouts of evaluation and backprop results, see basic_cpu_result_t. plans made
+        // outside of training have no backprop layout
+        size_t eval_size, inputs;
+        std::vector<cpu_layer_offsets_t> eval_layers;
+
+        size_t backprop_size, expected_outputs;
+        std::vector<cpu_layer_offsets_t> backprop_layers;
+
+        // if set, dense layers are multiplied against the evaluator's 16-bit copy of the weights
+        // with this kernel. compressed inputs and sparse layers are still picked per batch, as
+        // they depend on the data
+        _Ty (*reduced_dot)(const _Ty*, const uint16_t*, size_t);
+
+        // elements per buffer of scratch for layers evaluations do not keep, and per thread of csr
+        // scratch
+        size_t inference_scratch_size, csr_scratch_size;
+
+        // elements of each scratch buffer per pass: the widest layer evaluations do not keep
+        size_t inference_scratch_width;
+
+        // evaluations either hand every thread blocks of pass_grain passes to run through the
+        // whole network, or split each layer's neurons between threads
+        bool split_passes;
+        size_t pass_grain;
+    };
+
+    template <typename _Ty>
+    struct basic_cpu_result_t {
+        cpu_result_type type;
+        const basic_network<_Ty>* nn;
+        size_t passes;
+
+        // the plan this result was laid out with. only read while the result is queued
+        const basic_cpu_execution_plan_t<_Ty>* plan;
+
+        // whether the evaluator was in training mode when the result was created. only training
+        // evaluations keep what backprop needs
+        bool training;
+
+        // the plan's checkpoint interval, which backprop has to match
+        size_t checkpoint_interval;
+
+        // every block of the result lives in this one buffer, see cpu_layer_offsets_t
+        // for eval, inputs holds the inputs of every pass. for backprop, expected_outputs holds
+        // the outputs the evaluation is compared with
+        _Ty* data;
+        size_t size, inputs, expected_outputs;
+        std::vector<cpu_layer_offsets_t> layers;
+
+        // for eval, set if the inputs were sparse enough to be compressed, see
+        // cpu_evaluator::set_sparse_input_threshold. offsets is null otherwise
+        basic_cpu_sparse_inputs_t<_Ty> sparse_inputs;
+
+        // backing storage for data, reset as a whole when the result is freed
+        arena memory;
+
+        // for backprop, the evaluation being differentiated
+        const basic_cpu_result_t* source;
+
+        // set by the worker thread once results are computed
+        std::atomic<bool> ready;
+        std::exception_ptr exception;
+
+        // number of queued backprop passes reading from this result
+        mutable std::atomic<uint32_t> references;
+
+        // freed by the user, but still referenced
+        bool freed;
     };
 
-    struct cpu_backprop_data_t;
-    class NN_API cpu_evaluator : public evaluator {
+    // caller-owned scratch memory for cpu_evaluator::infer
+    // one workspace may be shared between networks, but not between threads
+    template <typename _Ty>
+    struct basic_cpu_workspace_t {
+        // sizes the workspace for the given network, so that infer does not have to
+        void reserve(const basic_network<_Ty>* nn);
+        void reserve(const quantized_network* nn);
+        void reserve(const factorized_network* nn);
+        void reserve(const reduced_network* nn);
+
+        std::vector<_Ty> scratch;
+        std::vector<int8_t> quantized_inputs;
+
+        // a factorized layer's inputs projected onto its rank
+        std::vector<_Ty> projected;
+    };
+
+    // evaluates networks of precision _Ty on the host, see basic_network
+    // instantiated for float and double. double precision runs on the scalar kernels
+    template <typename _Ty>
+    class basic_cpu_evaluator : public basic_evaluator<_Ty> {
     public:
-        cpu_evaluator() { m_key = 0; }
-        virtual ~cpu_evaluator() override = default;
+        using typename basic_evaluator<_Ty>::network_type;
+        using typename basic_evaluator<_Ty>::backprop_data_type;
+        using typename basic_evaluator<_Ty>::delta_composition_data_type;
+
+        using kernels_type = basic_cpu_kernels_t<_Ty>;
+        using result_type = basic_cpu_result_t<_Ty>;
+        using workspace_type = basic_cpu_workspace_t<_Ty>;
+
+        // thread_count of 0 uses every hardware thread on the host
+        basic_cpu_evaluator(size_t thread_count = 0);
+        virtual ~basic_cpu_evaluator() override;
 
         virtual evaluator_type get_type() const override { return evaluator_type::cpu; }
 
+        // kernels used for all dense math. defaults to the best set the host supports
+        const kernels_type& get_kernels() const { return *m_kernels; }
+
+        // forces a specific instruction set. returns false if it is unavailable
+        bool set_kernel_isa(cpu_isa isa);
+
+        // trades activation accuracy for speed, see cpu_activation_accuracy. defaults to precise
+        cpu_activation_accuracy get_activation_accuracy() const { return m_accuracy; }
+        void set_activation_accuracy(cpu_activation_accuracy accuracy);
+
+        size_t get_thread_count() const { return m_pool.get_thread_count(); }
+
+        // inputs with a smaller fraction of non-zero values than this are compressed, and the first
+        // layer only accumulates the non-zero columns, forward and backward. 0 disables this
+        number_t get_sparse_input_threshold() const { return m_sparse_threshold; }
+        void set_sparse_input_threshold(number_t density);
+
+        // layers with a smaller fraction of non-zero weights than this are evaluated from a
+        // compressed sparse row copy of their weights, kept alongside like the transposed one.
+        // only the forward pass reads it; backprop stays dense. 0 disables this
+        number_t get_sparse_weight_threshold() const { return m_sparse_weight_threshold; }
+        void set_sparse_weight_threshold(number_t density);
+
+        // training evaluations only keep the activations of every interval-th layer and the output
+        // layer, and backprop recomputes the rest between two checkpoints at a time. memory then
+        // grows with depth / interval rather than depth, for about one more forward pass per
+        // batch. evaluations begun with another interval cannot be backpropagated. 0 or 1 keeps
+        // every layer, the default
+        size_t get_checkpoint_interval() const { return m_checkpoint_interval; }
+        void set_checkpoint_interval(size_t interval);
+
+        // format evaluations read dense weights in. networks keep their weights in full precision,
+        // and the evaluator keeps a 16-bit copy of them alongside, which halves the memory traffic
+        // of batched forward passes but grows the memory held per weight by half (6 bytes instead
+        // of 4). backprop, sparse layers and infer on a network still read full precision weights.
+        // products are accumulated in full precision either way. for smaller inference-only
+        // weights, infer a reduced_network instead. defaults to fp32
+        parameter_format get_parameter_format() const { return m_parameter_format; }
+        void set_parameter_format(parameter_format format);
+
         virtual bool is_result_ready(uint64_t result) const override;
         virtual bool free_result(uint64_t result) override;
 
-        virtual std::optional<uint64_t> begin_eval(const network* nn,
-                                                   const std::vector<number_t>& inputs) override;
+        virtual std::optional<uint64_t> begin_eval(const network_type* nn,
+                                                   const std::vector<_Ty>& inputs) override;
 
-        virtual std::optional<uint64_t> begin_eval(const network* nn, void* native_inputs) override;
+        virtual std::optional<uint64_t> begin_eval(const network_type* nn,
+                                                   void* native_inputs) override;
 
         virtual bool get_eval_result(uint64_t result, void** outputs) override;
-        virtual void retrieve_eval_values(const network* nn, void* native_outputs,
-                                          std::vector<number_t>& outputs) override;
+        virtual void retrieve_eval_values(const network_type* nn, void* native_outputs,
+                                          std::vector<_Ty>& outputs) override;
+
+        virtual std::optional<uint64_t> begin_backprop(const network_type* nn,
+                                                       const backprop_data_type& data) override;
+
+        virtual bool compose_deltas(const delta_composition_data_type& data) override;
+
+        virtual _Ty cost_function(_Ty actual, _Ty expected,
+                                  activation_function output_function) const override;
+
+        // plans are also compiled on the first use of a shape, and kept until released or the
+        // network's weights are invalidated. compiling one ahead of time also sizes the scratch
+        // memory its evaluations use, so that not even the first of them allocates
+        virtual bool compile_plan(const network_type* nn, uint64_t batch_size) override;
+        virtual void release_plans(const network_type* nn) override;
+
+        // evaluates a single sample on the calling thread, bypassing the result queue. does not
+        // allocate once the workspace has been reserved for the network
+        // may run concurrently with queued work and other calls, each with its own workspace,
+        // but not with compose_deltas on the same network
+        // returns false if the input or output count does not match the network
+        bool infer(const network_type* nn, std::span<const _Ty> inputs, std::span<_Ty> outputs,
+                   workspace_type& workspace) const;
+
+        // same as above, with int8 weights and inputs accumulated in 32 bits. see
+        // quantized_network. single precision only
+        bool infer(const quantized_network* nn, std::span<const _Ty> inputs,
+                   std::span<_Ty> outputs, workspace_type& workspace) const
+            requires std::is_same_v<_Ty, number_t>;
+
+        // same as above, with every factorized layer evaluated as two thin products. see
+        // factorized_network. single precision only
+        bool infer(const factorized_network* nn, std::span<const _Ty> inputs,
+                   std::span<_Ty> outputs, workspace_type& workspace) const
+            requires std::is_same_v<_Ty, number_t>;
+
+        // same as above, with 16-bit weights widened as they are multiplied. see
+        // reduced_network. single precision only
+        bool infer(const reduced_network* nn, std::span<const _Ty> inputs,
+                   std::span<_Ty> outputs, workspace_type& workspace) const
+            requires std::is_same_v<_Ty, number_t>;
+
+        // blocks until every queued evaluation & backprop pass has finished
+        void wait_idle();
+
+        // backprop reads a transposed copy of each network's weights, as do evaluations with 16-bit
+        // parameters a reduced one and sparse layers a compressed one. compose_deltas keeps them
+        // up to date. call this after modifying a network's weights by any other means, or before
+        // reusing the address of a deleted network. also releases the network's plans
+        void invalidate_weights(const network_type* nn);
 
-        virtual std::optional<uint64_t> begin_backprop(const network* nn,
-                                                       const backprop_data_t& data) override;
+    private:
+        using plan_type = basic_cpu_execution_plan_t<_Ty>;
 
-        virtual bool compose_deltas(const delta_composition_data_t& data) override;
+        // looks up the plan for a shape, compiling it if there is none
+        const plan_type& get_plan(const network_type* nn, size_t passes, bool training);
 
-        virtual number_t cost_function(number_t actual, number_t expected) const override;
+        result_type& create_result(uint64_t key);
+        void release_result(uint64_t key);
+        void release_deferred();
 
-    private:
-        void eval(const number_t* inputs, cpu_result_t& result);
-        void backprop(const cpu_backprop_data_t& data, cpu_result_t& result, size_t offset);
+        // work is executed in submission order on a dedicated thread, see worker()
+        void submit(result_type& result);
+        void worker();
+        void execute(result_type& result);
+
+        void eval(result_type& result);
+        void backprop(result_type& result);
+
+        // where each layer's weights are read from, looked up once per batch
+        struct layer_sources_t {
+            // transposed first layer, if the inputs were compressed
+            const _Ty* input_weights;
+
+            const std::vector<std::vector<uint16_t>>* reduced_weights;
+            const std::vector<basic_sparse_weights_t<_Ty>>* sparse_weights;
+        };
+
+        layer_sources_t get_layer_sources(const result_type& eval_result);
+
+        // pre-activations of a block of a layer, computed the same way for evaluations and for
+        // layers recomputed by backprop
+        void multiply_layer(const layer_sources_t& sources, const result_type& eval_result,
+                            size_t layer_index, const _Ty* previous_activations, _Ty* z,
+                            size_t pass_begin, size_t pass_end, size_t row_begin, size_t row_end,
+                            size_t thread_index);
+
+        // the first layer is only transposed if input_layer is set, or it has been before
+        const std::vector<std::vector<_Ty>>& get_transposed_weights(const network_type* nn,
+                                                                    bool input_layer);
+
+        void update_transposed_weights(const network_type* nn,
+                                       std::vector<std::vector<_Ty>>& transposed,
+                                       bool input_layer);
+
+        const std::vector<std::vector<uint16_t>>& get_reduced_weights(const network_type* nn);
+        void update_reduced_weights(const network_type* nn,
+                                    std::vector<std::vector<uint16_t>>& reduced);
+
+        // layers above the sparse weight threshold are left empty (no offsets)
+        const std::vector<basic_sparse_weights_t<_Ty>>& get_sparse_weights(const network_type* nn);
+        // with compressed_only, layers that were left dense are not measured again
+        void update_sparse_weights(const network_type* nn,
+                                   std::vector<basic_sparse_weights_t<_Ty>>& sparse,
+                                   bool compressed_only);
 
         uint64_t m_key;
-        std::unordered_map<uint64_t, cpu_result_t> m_results;
+        std::unordered_map<uint64_t, result_type> m_results;
+
+        // released map nodes, reused along with their arenas by create_result
+        std::vector<typename std::unordered_map<uint64_t, result_type>::node_type> m_free_results;
+        const kernels_type* m_kernels;
+        cpu_activation_accuracy m_accuracy;
+        number_t m_sparse_threshold, m_sparse_weight_threshold;
+        parameter_format m_parameter_format;
+        size_t m_checkpoint_interval;
+
+        thread_pool m_pool;
+
+        // by network, batch size and training mode. only touched on the calling thread. queued
+        // results point into it, so plans are only erased while the worker is idle
+        std::map<std::tuple<const network_type*, size_t, bool>, plan_type> m_plans;
+
+        // scratch for compose_deltas, which runs on the calling thread while the worker is idle
+        // kept so that composing does not allocate once warm
+        std::vector<const _Ty*> m_compose_gradients;
+        std::vector<size_t> m_compose_offsets;
+
+        // outputs of the layers evaluations do not keep, ping-ponged from layer to layer
+        // only touched by the worker thread
+        std::vector<_Ty> m_inference_scratch;
+
+        // inputs interleaved by csr_multiply, one slice per pool thread
+        // only touched by the worker thread and its pool
+        std::vector<_Ty> m_csr_scratch;
+
+        // per network, each layer's weights transposed (previous_size x size)
+        // only touched by the worker thread, or while it is idle
+        std::unordered_map<const network_type*, std::vector<std::vector<_Ty>>> m_transposed_weights;
+
+        // per network, each layer's weights in m_parameter_format, if it is not fp32
+        // same access rules as m_transposed_weights
+        std::unordered_map<const network_type*, std::vector<std::vector<uint16_t>>>
+            m_reduced_weights;
+
+        // per network, each sparse layer's weights in compressed sparse row form
+        // same access rules as m_transposed_weights
+        std::unordered_map<const network_type*, std::vector<basic_sparse_weights_t<_Ty>>>
+            m_sparse_weights;
+
+        std::thread m_worker;
+        std::mutex m_queue_mutex;
+        std::condition_variable m_queue_cv, m_idle_cv;
+        bool m_stopping, m_busy;
+
+        // ring buffer of submitted results
+        std::vector<result_type*> m_queue;
+        size_t m_queue_head, m_queue_size;
+
+        std::vector<uint64_t> m_deferred_frees;
+
     };
+
+    extern template struct NN_API basic_cpu_workspace_t<float>;
+    extern template struct NN_API basic_cpu_workspace_t<double>;
+    extern template class NN_API basic_cpu_evaluator<float>;
+    extern template class NN_API basic_cpu_evaluator<double>;
+
+    using cpu_sparse_inputs_t = basic_cpu_sparse_inputs_t<number_t>;
+    using cpu_execution_plan_t = basic_cpu_execution_plan_t<number_t>;
+    using cpu_result_t = basic_cpu_result_t<number_t>;
+    using cpu_workspace_t = basic_cpu_workspace_t<number_t>;
+    using cpu_evaluator = basic_cpu_evaluator<number_t>;
 #endif
 
 #ifdef NN_SUPPORT_vulkan
@@ -221,6 +551,7 @@ namespace neuralnet::evaluators {
         uint64_t references;
     };
 
+    struct vulkan_execution_plan_t;
     struct vulkan_pass_data_t {
         vulkan_image_t activations, z, deltas;
         VkDescriptorSet descriptor_set;
@@ -229,6 +560,27 @@ namespace neuralnet::evaluators {
         size_t run_count;
 
         const network* nn;
+
+        // the plan this pass is returned to once unreferenced, if any
+        vulkan_execution_plan_t* plan;
+
+        // passes made for a plan record their evaluation & backprop once, reading inputs and
+        // expected outputs from these buffers. otherwise, every handle is null
+        vulkan_buffer_t inputs, expected_outputs;
+        VkCommandBuffer eval_commands, backprop_commands;
+        VkFence eval_fence, backprop_fence;
+
+        // backprop_commands is submitted and its result not yet freed
+        bool backprop_pending;
+    };
+
+    // passes of one network and run count, kept along with everything they own once no result
+    // references them, so that evaluating that shape again only uploads data and submits
+    struct vulkan_execution_plan_t {
+        const network* nn;
+        size_t run_count;
+
+        std::vector<uint64_t> passes, idle_passes;
     };
 
     enum class vulkan_result_type { eval, backprop };
@@ -239,6 +591,9 @@ namespace neuralnet::evaluators {
         VkCommandBuffer command_buffer;
         VkFence fence;
 
+        // command_buffer and fence belong to the pass, see vulkan_pass_data_t
+        bool recorded;
+
         std::vector<vulkan_buffer_t> staging_buffers;
     };
 
@@ -247,11 +602,17 @@ namespace neuralnet::evaluators {
         static void set_next_context(std::unique_ptr<vulkan_context_t>&& context);
         static bool is_context_valid();
 
-        vulkan_evaluator();
+        // format the network data image stores weights and biases in. fp16 and bf16 halve its size
+        // and the bandwidth evaluations read it with, while shaders still accumulate in fp32.
+        // deltas are composed straight into the image, so updates smaller than the format's
+        // precision are lost
+        vulkan_evaluator(parameter_format format = parameter_format::fp32);
         virtual ~vulkan_evaluator() override;
 
         virtual evaluator_type get_type() const override { return evaluator_type::vulkan; }
 
+        parameter_format get_parameter_format() const { return m_parameter_format; }
+
         virtual bool is_result_ready(uint64_t result) const override;
         virtual bool free_result(uint64_t result) override;
 
@@ -269,7 +630,13 @@ namespace neuralnet::evaluators {
 
         virtual bool compose_deltas(const delta_composition_data_t& data) override;
 
-        virtual number_t cost_function(number_t actual, number_t expected) const override;
+        virtual number_t cost_function(number_t actual, number_t expected,
+                                       activation_function output_function) const override;
+
+        // the images of a pass do not depend on the training mode, so plans are shared between
+        // modes. a plan keeps the network's data on the gpu until it is released
+        virtual bool compile_plan(const network* nn, uint64_t batch_size) override;
+        virtual void release_plans(const network* nn) override;
 
         vulkan_context_t* get_context();
         vulkan_network_data_t* get_network_data(const network* network);
@@ -285,20 +652,35 @@ namespace neuralnet::evaluators {
         void remove_pass_reference(uint64_t pass);
         uint64_t new_pass(const network* network, const std::vector<number_t>& inputs);
 
+        // creates a pass's images and descriptor set, without initializing them
+        uint64_t create_pass(const network* network, size_t run_count);
+        void destroy_pass(vulkan_pass_data_t& pass);
+
+        // takes an idle pass from the plan, or makes a new one
+        uint64_t acquire_pass(vulkan_execution_plan_t& plan);
+
+        void record_eval(VkCommandBuffer command_buffer, const vulkan_pass_data_t& pass);
+        void record_backprop(VkCommandBuffer command_buffer, const vulkan_pass_data_t& pass,
+                             const vulkan_buffer_t& expected_outputs);
+
         void copy_network_from_gpu(network* nn);
 
         std::unique_ptr<vulkan_context_t> m_context;
         vulkan_evaluator_objects_t m_objects;
         bool m_profiling_enabled;
+        parameter_format m_parameter_format;
 
         uint64_t m_current_pass_id, m_current_result_id;
         std::unordered_map<const network*, vulkan_network_data_t> m_network_data;
         std::unordered_map<uint64_t, vulkan_result_t> m_results;
         std::unordered_map<uint64_t, vulkan_pass_data_t> m_passes;
+
+        // by network and run count. passes point into it, so entries are never moved
+        std::map<std::tuple<const network*, size_t>, vulkan_execution_plan_t> m_plans;
     };
 #endif
 
     NN_API bool is_evaluator_supported(evaluator_type type);
     NN_API evaluator_type get_preferred_evaluator();
     NN_API evaluator* choose_evaluator(evaluator_type preferred = evaluator_type::other);
-} // namespace neuralnet::evaluators
+} // namespace neuralnet::evaluators
\ No newline at end of file
@@ -27,6 +27,49 @@ namespace neuralnet::evaluators {
     static constexpr VkImageLayout transfer_dst_layout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
     static constexpr VkPipelineStageFlags transfer_stage = VK_PIPELINE_STAGE_TRANSFER_BIT;
 
+    // format of the network data image, see PARAMETER_FORMAT in include/buffers.glsl
+    // there is no bfloat16 image format, so those are stored as raw bits
+    static VkFormat get_parameter_image_format(parameter_format format) {
+        switch (format) {
+        case parameter_format::fp32:
+            return VK_FORMAT_R32_SFLOAT;
+        case parameter_format::fp16:
+            return VK_FORMAT_R16_SFLOAT;
+        case parameter_format::bf16:
+            return VK_FORMAT_R16_UINT;
+        default:
+            throw std::runtime_error("invalid parameter format!");
+        }
+    }
+
+    // suffix of the shader variant compiled for a parameter format, see CMakeLists.txt
+    static std::string get_shader_suffix(parameter_format format) {
+        if (format == parameter_format::fp32) {
+            return "";
+        }
+
+        return "_" + std::string(get_parameter_format_name(format));
+    }
+
+    // staging buffers hold parameters in the data image's format; copies do not convert
+    static void write_parameters(const number_t* src, void* dst, size_t count,
+                                 parameter_format format) {
+        if (format == parameter_format::fp32) {
+            copy(src, dst, count * sizeof(number_t));
+        } else {
+            reduce_parameters(src, (uint16_t*)dst, count, format);
+        }
+    }
+
+    static void read_parameters(const void* src, number_t* dst, size_t count,
+                                parameter_format format) {
+        if (format == parameter_format::fp32) {
+            copy(src, dst, count * sizeof(number_t));
+        } else {
+            widen_parameters((const uint16_t*)src, dst, count, format);
+        }
+    }
+
     static VkBool32 vulkan_debug_callback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity,
                                           VkDebugUtilsMessageTypeFlagsEXT messageTypes,
                                           const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
@@ -231,7 +274,7 @@ namespace neuralnet::evaluators {
 
     static void create_vulkan_image(vulkan_context_t* context, VkImageType type,
                                     VkImageViewType view_type, const VkExtent3D& size,
-                                    vulkan_image_t* image) {
+                                    vulkan_image_t* image, VkFormat format = image_format) {
         ZoneScoped;
 
         const auto& v = context->vtable;
@@ -254,7 +297,7 @@ namespace neuralnet::evaluators {
         create_info.extent = size;
         create_info.arrayLayers = 1;
         create_info.mipLevels = 1;
-        create_info.format = image_format;
+        create_info.format = format;
         create_info.tiling = image_tiling;
         create_info.usage = image_usage | context->handles.additional_image_usage;
         create_info.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -278,7 +321,7 @@ namespace neuralnet::evaluators {
         view_info.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
         view_info.image = image->image;
         view_info.viewType = view_type;
-        view_info.format = image_format;
+        view_info.format = format;
         view_info.subresourceRange.aspectMask = image_aspect_flags;
         view_info.subresourceRange.layerCount = 1;
         view_info.subresourceRange.levelCount = 1;
@@ -427,8 +470,25 @@ namespace neuralnet::evaluators {
         return true;
     }
 
+    // 16-bit formats additionally need shaderStorageImageExtendedFormats for their shader format
+    // qualifiers
+    static bool device_supports_parameter_format(VkPhysicalDevice device, VkFormat format,
+                                                 vulkan_context_t* context) {
+        ZoneScoped;
+
+        if (format == image_format) {
+            return true;
+        }
+
+        VkPhysicalDeviceFeatures features;
+        context->vtable.vkGetPhysicalDeviceFeatures(device, &features);
+
+        return features.shaderStorageImageExtendedFormats &&
+               device_supports_format(device, image_tiling, format, context);
+    }
+
     static uint32_t score_device(VkPhysicalDevice device, uint32_t* compute_queue_index,
-                                 vulkan_context_t* context) {
+                                 VkFormat parameter_image_format, vulkan_context_t* context) {
         ZoneScoped;
         const auto& v = context->vtable;
 
@@ -452,7 +512,8 @@ namespace neuralnet::evaluators {
         }
 
         if (!found_compute ||
-            !device_supports_format(device, image_tiling, image_format, context)) {
+            !device_supports_format(device, image_tiling, image_format, context) ||
+            !device_supports_parameter_format(device, parameter_image_format, context)) {
             std::string message =
                 "Vulkan device \"" + std::string(properties.deviceName) + "\" not suitable";
 
@@ -482,7 +543,7 @@ namespace neuralnet::evaluators {
         return score;
     }
 
-    static void select_physical_device(vulkan_context_t* context) {
+    static void select_physical_device(vulkan_context_t* context, VkFormat parameter_image_format) {
         ZoneScoped;
         const auto& v = context->vtable;
 
@@ -501,7 +562,8 @@ namespace neuralnet::evaluators {
             auto device = devices[i];
 
             uint32_t compute_index;
-            uint32_t score = score_device(device, &compute_index, context);
+            uint32_t score =
+                score_device(device, &compute_index, parameter_image_format, context);
 
             if (score > max_score) {
                 max_score = score;
@@ -675,7 +737,8 @@ namespace neuralnet::evaluators {
                                                      &v.alloc_callbacks, layout));
     }
 
-    static void create_objects(vulkan_evaluator_objects_t* objects, vulkan_context_t* context) {
+    static void create_objects(vulkan_evaluator_objects_t* objects, vulkan_context_t* context,
+                               parameter_format format) {
         ZoneScoped;
 
         const auto& v = context->vtable;
@@ -718,8 +781,8 @@ namespace neuralnet::evaluators {
             { 1, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT }
         };
 
-        static const std::vector<std::string> shader_names = { "evaluation", "backpropagation",
-                                                               "deltas" };
+        static const std::vector<std::string> shader_names = { "evaluation", "softmax",
+                                                               "backpropagation", "deltas" };
 
         create_set_layout(context, &objects->evaluation_layout, evaluation_bindings);
         create_set_layout(context, &objects->network_layout, network_bindings);
@@ -746,7 +809,8 @@ namespace neuralnet::evaluators {
         std::vector<VkComputePipelineCreateInfo> pipeline_specs;
 
         for (const auto& name : shader_names) {
-            std::string shader_path = "neuralnet/resources/spirv/" + name + ".spv";
+            std::string shader_path =
+                "neuralnet/resources/spirv/" + name + get_shader_suffix(format) + ".spv";
             const auto& shader_resource = resource::get(shader_path);
 
             VkShaderModuleCreateInfo module_info{};
@@ -824,9 +888,11 @@ namespace neuralnet::evaluators {
         }
 
         vtable_load_instance(m_context->vtable, m_context->handles.instance);
+        VkFormat parameter_image_format = get_parameter_image_format(m_parameter_format);
+
         if (!m_context->handles.context_provided) {
             create_debug_messenger(m_context.get());
-            select_physical_device(m_context.get());
+            select_physical_device(m_context.get(), parameter_image_format);
 
             user_callback_t chosen = m_context->vtable.user_callbacks.device_chosen;
             if (chosen != nullptr) {
@@ -836,8 +902,13 @@ namespace neuralnet::evaluators {
             create_device(m_context.get());
         }
 
+        if (!device_supports_parameter_format(m_context->handles.physical_device,
+                                              parameter_image_format, m_context.get())) {
+            throw std::runtime_error("Parameter format not supported by the Vulkan device!");
+        }
+
         vtable_load_device(m_context->vtable, m_context->handles.device);
-        create_objects(&m_objects, m_context.get());
+        create_objects(&m_objects, m_context.get(), m_parameter_format);
 
         if (m_context->handles.context_provided) {
             m_profiling_enabled = m_context->handles.profiler_context != nullptr;
@@ -892,7 +963,7 @@ namespace neuralnet::evaluators {
         }
     }
 
-    vulkan_evaluator::vulkan_evaluator() {
+    vulkan_evaluator::vulkan_evaluator(parameter_format format) {
         ZoneScoped;
         if (!is_context_valid()) {
             throw std::runtime_error("No valid context!");
@@ -901,6 +972,7 @@ namespace neuralnet::evaluators {
         m_context = std::move(s_next_context);
         s_next_context.reset(); // just to be safe
 
+        m_parameter_format = format;
         init_vulkan();
 
         m_current_pass_id = 0;
@@ -920,6 +992,10 @@ namespace neuralnet::evaluators {
             free_result(id);
         }
 
+        while (!m_plans.empty()) {
+            release_plans(std::get<0>(m_plans.begin()->first));
+        }
+
         std::vector<const network*> networks;
         for (auto& [nn, data] : m_network_data) {
             data.references = 1;
@@ -958,9 +1034,13 @@ namespace neuralnet::evaluators {
         const auto& v = m_context->vtable;
         const auto& handles = m_context->handles;
 
-        v.vkDestroyFence(handles.device, result_data.fence, &v.alloc_callbacks);
-        v.vkFreeCommandBuffers(handles.device, m_objects.command_pool, 1,
-                               &result_data.command_buffer);
+        if (!result_data.recorded) {
+            v.vkDestroyFence(handles.device, result_data.fence, &v.alloc_callbacks);
+            v.vkFreeCommandBuffers(handles.device, m_objects.command_pool, 1,
+                                   &result_data.command_buffer);
+        } else if (result_data.type == vulkan_result_type::backprop) {
+            m_passes.at(result_data.pass).backprop_pending = false;
+        }
 
         for (const auto& buffer : result_data.staging_buffers) {
             destroy_vulkan_buffer(m_context.get(), &buffer);
@@ -1044,6 +1124,35 @@ namespace neuralnet::evaluators {
         const auto& v = context->vtable;
         v.check_result(v.vkCreateFence(context->handles.device, &fence_info, &v.alloc_callbacks,
                                        &result->fence));
+
+        result->recorded = false;
+    }
+
+    // submits a command buffer recorded ahead of time, see vulkan_pass_data_t
+    static void submit_recorded_commands(vulkan_context_t* context, VkQueue queue,
+                                         VkCommandBuffer command_buffer, VkFence fence) {
+        ZoneScoped;
+        const auto& v = context->vtable;
+
+        VkSubmitInfo submit_info{};
+        submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+        submit_info.commandBufferCount = 1;
+        submit_info.pCommandBuffers = &command_buffer;
+
+        v.check_result(v.vkResetFences(context->handles.device, 1, &fence));
+        v.check_result(v.vkQueueSubmit(queue, 1, &submit_info, fence));
+    }
+
+    static void write_staging_buffer(vulkan_context_t* context, const vulkan_buffer_t& buffer,
+                                     const void* data, size_t size) {
+        ZoneScoped;
+
+        void* mapped = nullptr;
+        context->vtable.check_result(
+            vmaMapMemory(context->handles.allocator, buffer.allocation, &mapped));
+
+        copy(data, mapped, std::min(size, buffer.size));
+        vmaUnmapMemory(context->handles.allocator, buffer.allocation);
     }
 
     std::optional<uint64_t> vulkan_evaluator::begin_eval(const network* nn,
@@ -1081,35 +1190,25 @@ namespace neuralnet::evaluators {
         barrier.subresourceRange.levelCount = 1;
     }
 
-    std::optional<uint64_t> vulkan_evaluator::begin_eval(const network* nn, void* native_inputs) {
+    void vulkan_evaluator::record_eval(VkCommandBuffer command_buffer,
+                                       const vulkan_pass_data_t& pass) {
         ZoneScoped;
-        const auto& inputs = *(const std::vector<number_t>*)native_inputs;
-
-        uint64_t pass = new_pass(nn, inputs);
-        uint64_t result = m_current_result_id++;
-
-        auto& result_data = m_results[result];
-        new_vulkan_result(m_context.get(), m_objects.command_pool, &result_data);
-
-        result_data.pass = pass;
-        result_data.type = vulkan_result_type::eval;
 
-        const auto& network_data = m_network_data.at(nn);
-        const auto& pass_data = m_passes.at(pass);
+        const auto& network_data = m_network_data.at(pass.nn);
         const auto& v = m_context->vtable;
 
         VkPipeline pipeline = m_objects.pipelines.at("evaluation");
-        v.vkCmdBindPipeline(result_data.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        v.vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 
-        std::vector<VkDescriptorSet> descriptor_sets = { pass_data.descriptor_set,
+        std::vector<VkDescriptorSet> descriptor_sets = { pass.descriptor_set,
                                                          network_data.descriptor_set };
 
-        v.vkCmdBindDescriptorSets(result_data.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+        v.vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
                                   m_objects.pipeline_layout, 0, 2, descriptor_sets.data(), 0,
                                   nullptr);
 
         std::vector<VkImageMemoryBarrier> image_barriers;
-        std::vector<VkImage> protected_images = { pass_data.activations.image, pass_data.z.image };
+        std::vector<VkImage> protected_images = { pass.activations.image, pass.z.image };
 
         for (VkImage image : protected_images) {
             auto& barrier = image_barriers.emplace_back();
@@ -1117,33 +1216,84 @@ namespace neuralnet::evaluators {
                                  image_compute_layout, image_compute_layout);
         }
 
-        {
-            TracyVkZoneTransient(m_context->handles.profiler_context, vk_zone,
-                                 result_data.command_buffer, "Network evaluation",
-                                 m_profiling_enabled);
+        const auto& layers = pass.nn->get_layers();
+        for (uint32_t i = 0; i < layers.size(); i++) {
+            if (i > 0) {
+                static constexpr VkPipelineStageFlags stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                v.vkCmdPipelineBarrier(command_buffer, stage, stage, 0, 0, nullptr, 0, nullptr,
+                                       (uint32_t)image_barriers.size(), image_barriers.data());
+            }
 
-            const auto& layers = nn->get_layers();
-            for (uint32_t i = 0; i < layers.size(); i++) {
-                if (i > 0) {
-                    static constexpr VkPipelineStageFlags stage =
-                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                    v.vkCmdPipelineBarrier(result_data.command_buffer, stage, stage, 0, 0, nullptr,
-                                           0, nullptr, (uint32_t)image_barriers.size(),
-                                           image_barriers.data());
-                }
+            v.vkCmdPushConstants(command_buffer, m_objects.pipeline_layout,
+                                 VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &i);
+
+            VkExtent3D work_groups;
+            work_groups.width = get_work_group_count(layers[i].size);
+            work_groups.height = get_work_group_count(pass.run_count);
+            work_groups.depth = 1;
+
+            v.vkCmdDispatch(command_buffer, work_groups.width, work_groups.height,
+                            work_groups.depth);
 
-                v.vkCmdPushConstants(result_data.command_buffer, m_objects.pipeline_layout,
-                                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &i);
+            // softmax needs every z of the layer, so it is applied by a second dispatch, with one
+            // work group per pass. it is only allowed on the output layer, so nothing is
+            // dispatched with evaluation after it
+            if (layers[i].function == activation_function::softmax) {
+                static constexpr VkPipelineStageFlags stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                v.vkCmdPipelineBarrier(command_buffer, stage, stage, 0, 0, nullptr, 0, nullptr,
+                                       (uint32_t)image_barriers.size(), image_barriers.data());
 
-                VkExtent3D work_groups;
-                work_groups.width = get_work_group_count(layers[i].size);
-                work_groups.height = get_work_group_count(pass_data.run_count);
-                work_groups.depth = 1;
+                VkPipeline softmax_pipeline = m_objects.pipelines.at("softmax");
+                v.vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+                                    softmax_pipeline);
 
-                v.vkCmdDispatch(result_data.command_buffer, work_groups.width, work_groups.height,
-                                work_groups.depth);
+                v.vkCmdDispatch(command_buffer, 1, (uint32_t)pass.run_count, 1);
             }
         }
+    }
+
+    std::optional<uint64_t> vulkan_evaluator::begin_eval(const network* nn, void* native_inputs) {
+        ZoneScoped;
+        const auto& inputs = *(const std::vector<number_t>*)native_inputs;
+
+        uint64_t input_neurons = nn->get_layers()[0].previous_size;
+        size_t run_count = (inputs.size() - (inputs.size() % input_neurons)) / input_neurons;
+
+        uint64_t result = m_current_result_id++;
+        auto& result_data = m_results[result];
+        result_data.type = vulkan_result_type::eval;
+
+        // a planned pass has its evaluation recorded already; only the inputs change
+        auto plan = m_plans.find(std::make_tuple(nn, run_count));
+        if (plan != m_plans.end()) {
+            uint64_t pass = acquire_pass(plan->second);
+            const auto& pass_data = m_passes.at(pass);
+
+            write_staging_buffer(m_context.get(), pass_data.inputs, inputs.data(),
+                                 inputs.size() * sizeof(number_t));
+
+            result_data.pass = pass;
+            result_data.recorded = true;
+            result_data.command_buffer = pass_data.eval_commands;
+            result_data.fence = pass_data.eval_fence;
+
+            submit_recorded_commands(m_context.get(), m_objects.compute_queue,
+                                     result_data.command_buffer, result_data.fence);
+
+            return result;
+        }
+
+        uint64_t pass = new_pass(nn, inputs);
+        new_vulkan_result(m_context.get(), m_objects.command_pool, &result_data);
+        result_data.pass = pass;
+
+        {
+            TracyVkZoneTransient(m_context->handles.profiler_context, vk_zone,
+                                 result_data.command_buffer, "Network evaluation",
+                                 m_profiling_enabled);
+
+            record_eval(result_data.command_buffer, m_passes.at(pass));
+        }
 
         end_and_submit_command_buffer(m_context.get(), m_objects.compute_queue,
                                       result_data.command_buffer, false, result_data.fence);
@@ -1225,36 +1375,26 @@ namespace neuralnet::evaluators {
         v.vkFreeCommandBuffers(handles.device, m_objects.command_pool, 1, &command_buffer);
     }
 
-    std::optional<uint64_t> vulkan_evaluator::begin_backprop(const network* nn,
-                                                             const backprop_data_t& data) {
+    void vulkan_evaluator::record_backprop(VkCommandBuffer command_buffer,
+                                           const vulkan_pass_data_t& pass,
+                                           const vulkan_buffer_t& expected_outputs) {
         ZoneScoped;
 
-        auto& pass_data = *(vulkan_pass_data_t*)data.eval_outputs;
-        uint64_t pass = pass_data.pass_id;
-        uint64_t result = m_current_result_id++;
-
-        auto& result_data = m_results[result];
-        new_vulkan_result(m_context.get(), m_objects.command_pool, &result_data);
-
-        result_data.pass = pass;
-        result_data.type = vulkan_result_type::backprop;
-
-        const auto& network_data = m_network_data.at(nn);
+        const auto& network_data = m_network_data.at(pass.nn);
         const auto& v = m_context->vtable;
-        const auto& handles = m_context->handles;
 
         VkPipeline pipeline = m_objects.pipelines.at("backpropagation");
-        v.vkCmdBindPipeline(result_data.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
+        v.vkCmdBindPipeline(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, pipeline);
 
-        std::vector<VkDescriptorSet> descriptor_sets = { pass_data.descriptor_set,
+        std::vector<VkDescriptorSet> descriptor_sets = { pass.descriptor_set,
                                                          network_data.descriptor_set };
 
-        v.vkCmdBindDescriptorSets(result_data.command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
+        v.vkCmdBindDescriptorSets(command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE,
                                   m_objects.pipeline_layout, 0, 2, descriptor_sets.data(), 0,
                                   nullptr);
 
         std::vector<VkImageMemoryBarrier> image_barriers;
-        std::vector<VkImage> protected_images = { pass_data.activations.image, pass_data.z.image };
+        std::vector<VkImage> protected_images = { pass.activations.image, pass.z.image };
 
         for (VkImage image : protected_images) {
             auto& barrier = image_barriers.emplace_back();
@@ -1263,32 +1403,24 @@ namespace neuralnet::evaluators {
         }
 
         VkImageMemoryBarrier src_barrier, dst_barrier;
-        create_image_barrier(src_barrier, pass_data.activations.image, image_access_flags,
+        create_image_barrier(src_barrier, pass.activations.image, image_access_flags,
                              transfer_dst_access, image_compute_layout, transfer_dst_layout);
-        create_image_barrier(dst_barrier, pass_data.activations.image, transfer_dst_access,
+        create_image_barrier(dst_barrier, pass.activations.image, transfer_dst_access,
                              image_access_flags, transfer_dst_layout, image_compute_layout);
 
-        auto& staging_buffer = result_data.staging_buffers.emplace_back();
-        create_vulkan_buffer(m_context.get(), data.expected_outputs.size() * sizeof(number_t),
-                             &staging_buffer);
-
-        void* mapped = nullptr;
-        v.check_result(vmaMapMemory(handles.allocator, staging_buffer.allocation, &mapped));
-        copy(data.expected_outputs.data(), mapped, staging_buffer.size);
-        vmaUnmapMemory(handles.allocator, staging_buffer.allocation);
-
-        const auto& layers = nn->get_layers();
+        const auto& layers = pass.nn->get_layers();
         uint64_t output_count = layers[layers.size() - 1].size;
 
         std::vector<VkBufferImageCopy> regions;
-        for (size_t i = 0; i < pass_data.run_count; i++) {
+        for (size_t i = 0; i < pass.run_count; i++) {
             auto& region = regions.emplace_back();
             std::memset(&region, 0, sizeof(VkBufferImageCopy));
 
+            region.bufferOffset = (VkDeviceSize)(i * output_count * sizeof(number_t));
             region.imageExtent.width = (uint32_t)output_count;
             region.imageExtent.height = 1;
             region.imageExtent.depth = 1;
-            region.imageOffset.y = (uint32_t)pass_data.activations.size.height - 1;
+            region.imageOffset.y = (uint32_t)pass.activations.size.height - 1;
             region.imageOffset.z = (uint32_t)i;
             region.imageSubresource.aspectMask = image_aspect_flags;
             region.imageSubresource.baseArrayLayer = 0;
@@ -1296,44 +1428,79 @@ namespace neuralnet::evaluators {
             region.imageSubresource.mipLevel = 0;
         }
 
-        {
-            TracyVkZoneTransient(m_context->handles.profiler_context, vk_zone,
-                                 result_data.command_buffer, "Network backpropagation",
-                                 m_profiling_enabled);
+        v.vkCmdPipelineBarrier(command_buffer, compute_stage, transfer_stage, 0, 0, nullptr, 0,
+                               nullptr, 1, &src_barrier);
 
-            v.vkCmdPipelineBarrier(result_data.command_buffer, compute_stage, transfer_stage, 0, 0,
-                                   nullptr, 0, nullptr, 1, &src_barrier);
+        v.vkCmdCopyBufferToImage(command_buffer, expected_outputs.buffer, pass.activations.image,
+                                 transfer_dst_layout, (uint32_t)regions.size(), regions.data());
 
-            v.vkCmdCopyBufferToImage(result_data.command_buffer, staging_buffer.buffer,
-                                     pass_data.activations.image, transfer_dst_layout,
-                                     (uint32_t)regions.size(), regions.data());
+        v.vkCmdPipelineBarrier(command_buffer, transfer_stage, compute_stage, 0, 0, nullptr, 0,
+                               nullptr, 1, &dst_barrier);
 
-            v.vkCmdPipelineBarrier(result_data.command_buffer, transfer_stage, compute_stage, 0, 0,
-                                   nullptr, 0, nullptr, 1, &dst_barrier);
+        for (uint32_t i = 0; i < layers.size(); i++) {
+            if (i > 0) {
+                static constexpr VkPipelineStageFlags stage = VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                v.vkCmdPipelineBarrier(command_buffer, stage, stage, 0, 0, nullptr, 0, nullptr,
+                                       (uint32_t)image_barriers.size(), image_barriers.data());
+            }
 
-            const auto& layers = nn->get_layers();
-            for (uint32_t i = 0; i < layers.size(); i++) {
-                if (i > 0) {
-                    static constexpr VkPipelineStageFlags stage =
-                        VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
-                    v.vkCmdPipelineBarrier(result_data.command_buffer, stage, stage, 0, 0, nullptr,
-                                           0, nullptr, (uint32_t)image_barriers.size(),
-                                           image_barriers.data());
-                }
+            uint32_t layer_index = (uint32_t)layers.size() - (i + 1);
+            v.vkCmdPushConstants(command_buffer, m_objects.pipeline_layout,
+                                 VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t), &layer_index);
 
-                uint32_t layer_index = (uint32_t)layers.size() - (i + 1);
-                v.vkCmdPushConstants(result_data.command_buffer, m_objects.pipeline_layout,
-                                     VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(uint32_t),
-                                     &layer_index);
+            VkExtent3D work_groups;
+            work_groups.width = get_work_group_count(layers[i].size);
+            work_groups.height = get_work_group_count(pass.run_count);
+            work_groups.depth = 1;
 
-                VkExtent3D work_groups;
-                work_groups.width = get_work_group_count(layers[i].size);
-                work_groups.height = get_work_group_count(pass_data.run_count);
-                work_groups.depth = 1;
+            v.vkCmdDispatch(command_buffer, work_groups.width, work_groups.height,
+                            work_groups.depth);
+        }
+    }
 
-                v.vkCmdDispatch(result_data.command_buffer, work_groups.width, work_groups.height,
-                                work_groups.depth);
-            }
+    std::optional<uint64_t> vulkan_evaluator::begin_backprop(const network* nn,
+                                                             const backprop_data_t& data) {
+        ZoneScoped;
+
+        auto& pass_data = *(vulkan_pass_data_t*)data.eval_outputs;
+        uint64_t pass = pass_data.pass_id;
+        uint64_t result = m_current_result_id++;
+
+        auto& result_data = m_results[result];
+        result_data.pass = pass;
+        result_data.type = vulkan_result_type::backprop;
+
+        // planned passes have one backprop recorded, which may only be in flight once
+        size_t output_size = data.expected_outputs.size() * sizeof(number_t);
+        if (pass_data.backprop_commands != VK_NULL_HANDLE && !pass_data.backprop_pending) {
+            write_staging_buffer(m_context.get(), pass_data.expected_outputs,
+                                 data.expected_outputs.data(), output_size);
+
+            result_data.recorded = true;
+            result_data.command_buffer = pass_data.backprop_commands;
+            result_data.fence = pass_data.backprop_fence;
+
+            submit_recorded_commands(m_context.get(), m_objects.compute_queue,
+                                     result_data.command_buffer, result_data.fence);
+
+            pass_data.backprop_pending = true;
+            pass_data.references++;
+            return result;
+        }
+
+        new_vulkan_result(m_context.get(), m_objects.command_pool, &result_data);
+
+        auto& staging_buffer = result_data.staging_buffers.emplace_back();
+        create_vulkan_buffer(m_context.get(), output_size, &staging_buffer);
+        write_staging_buffer(m_context.get(), staging_buffer, data.expected_outputs.data(),
+                             output_size);
+
+        {
+            TracyVkZoneTransient(m_context->handles.profiler_context, vk_zone,
+                                 result_data.command_buffer, "Network backpropagation",
+                                 m_profiling_enabled);
+
+            record_backprop(result_data.command_buffer, pass_data, staging_buffer);
         }
 
         end_and_submit_command_buffer(m_context.get(), m_objects.compute_queue,
@@ -1354,6 +1521,7 @@ namespace neuralnet::evaluators {
         std::vector<VkBufferImageCopy> regions;
         size_t data_size = 0;
 
+        size_t element_size = get_parameter_format_size(m_parameter_format);
         auto& layers = nn->get_layers();
         for (size_t i = 0; i < nn->get_layers().size(); i++) {
             const auto& layer = layers[i];
@@ -1370,7 +1538,7 @@ namespace neuralnet::evaluators {
             region.imageSubresource.mipLevel = 0;
             regions.push_back(region);
 
-            data_size += sizeof(number_t) * region.imageExtent.width * region.imageExtent.height;
+            data_size += element_size * region.imageExtent.width * region.imageExtent.height;
         }
 
         VkCommandBuffer command_buffer =
@@ -1403,17 +1571,18 @@ namespace neuralnet::evaluators {
 
         v.vkFreeCommandBuffers(handles.device, m_objects.command_pool, 1, &command_buffer);
 
-        number_t* mapped = nullptr;
+        uint8_t* mapped = nullptr;
         v.check_result(vmaMapMemory(handles.allocator, staging_buffer.allocation, (void**)&mapped));
 
         size_t offset = 0;
         for (auto& layer : layers) {
             for (uint64_t c = 0; c < layer.size; c++) {
                 size_t current_offset = offset + c * (layer.previous_size + 1);
-                layer.biases[c] = mapped[current_offset];
+                const uint8_t* row = &mapped[current_offset * element_size];
 
-                copy(&mapped[current_offset + 1], &layer.weights[c * layer.previous_size],
-                     layer.previous_size * sizeof(number_t));
+                read_parameters(row, &layer.biases[c], 1, m_parameter_format);
+                read_parameters(&row[element_size], &layer.weights[c * layer.previous_size],
+                                layer.previous_size, m_parameter_format);
             }
 
             offset += layer.size * (layer.previous_size + 1);
@@ -1497,9 +1666,15 @@ namespace neuralnet::evaluators {
         return true;
     }
 
-    number_t vulkan_evaluator::cost_function(number_t actual, number_t expected) const {
+    number_t vulkan_evaluator::cost_function(number_t actual, number_t expected,
+                                             activation_function output_function) const {
         ZoneScoped;
 
+        // -y * ln(x), see backpropagation.glsl
+        if (output_function == activation_function::softmax) {
+            return -expected * std::log(std::max(actual, std::numeric_limits<number_t>::min()));
+        }
+
         // (x - y)^2
         // see include/functions.glsl
 
@@ -1562,14 +1737,16 @@ namespace neuralnet::evaluators {
     }
 
     static void create_network_staging_buffer(vulkan_context_t* context, const network* nn,
-                                              vulkan_buffer_t* buffer,
+                                              parameter_format format, vulkan_buffer_t* buffer,
                                               std::vector<VkBufferImageCopy>& regions) {
         ZoneScoped;
 
+        size_t element_size = get_parameter_format_size(format);
         size_t total_size = 0;
+
         const auto& layers = nn->get_layers();
         for (const auto& layer : layers) {
-            total_size += sizeof(number_t) * layer.size * (layer.previous_size + 1);
+            total_size += element_size * layer.size * (layer.previous_size + 1);
         }
 
         create_vulkan_buffer(context, total_size, buffer);
@@ -1577,7 +1754,7 @@ namespace neuralnet::evaluators {
         const auto& v = context->vtable;
         const auto& handles = context->handles;
 
-        number_t* mapped = nullptr;
+        uint8_t* mapped = nullptr;
         v.check_result(vmaMapMemory(handles.allocator, buffer->allocation, (void**)&mapped));
 
         size_t current_offset = 0;
@@ -1585,7 +1762,7 @@ namespace neuralnet::evaluators {
             const auto& layer = layers[i];
 
             VkBufferImageCopy region{};
-            region.bufferOffset = (VkDeviceSize)current_offset * sizeof(number_t);
+            region.bufferOffset = (VkDeviceSize)(current_offset * element_size);
             region.imageExtent.width = (uint32_t)(layer.previous_size + 1);
             region.imageExtent.height = (uint32_t)layer.size;
             region.imageExtent.depth = 1;
@@ -1597,9 +1774,10 @@ namespace neuralnet::evaluators {
             regions.push_back(region);
 
             for (uint64_t c = 0; c < layer.size; c++) {
-                mapped[current_offset] = layer.biases[c];
-                copy(&layer.weights[c * layer.previous_size], &mapped[current_offset + 1],
-                     layer.previous_size * sizeof(number_t));
+                uint8_t* row = &mapped[current_offset * element_size];
+                write_parameters(&layer.biases[c], row, 1, format);
+                write_parameters(&layer.weights[c * layer.previous_size], &row[element_size],
+                                 layer.previous_size, format);
 
                 current_offset += layer.previous_size + 1;
             }
@@ -1630,7 +1808,8 @@ namespace neuralnet::evaluators {
 
             create_vulkan_buffer(m_context.get(), buffer_size, &data.info_buffer);
             create_vulkan_image(m_context.get(), VK_IMAGE_TYPE_3D, VK_IMAGE_VIEW_TYPE_3D,
-                                image_size, &data.data_image);
+                                image_size, &data.data_image,
+                                get_parameter_image_format(m_parameter_format));
 
             alloc_descriptor_sets(m_context.get(), m_objects.network_layout,
                                   m_objects.descriptor_pool, 1, &data.descriptor_set);
@@ -1693,7 +1872,8 @@ namespace neuralnet::evaluators {
 
             vulkan_buffer_t staging_buffer;
             std::vector<VkBufferImageCopy> regions;
-            create_network_staging_buffer(m_context.get(), nn, &staging_buffer, regions);
+            create_network_staging_buffer(m_context.get(), nn, m_parameter_format, &staging_buffer,
+                                          regions);
 
             VkCommandBuffer command_buffer =
                 alloc_open_command_buffer(m_context.get(), m_objects.command_pool);
@@ -1740,38 +1920,63 @@ namespace neuralnet::evaluators {
 
         auto& data = m_passes[pass];
         if (--data.references == 0) {
+            if (data.plan != nullptr) {
+                data.plan->idle_passes.push_back(pass);
+                return;
+            }
+
             remove_network_reference(data.nn);
+            destroy_pass(data);
 
-            const auto& v = m_context->vtable;
-            const auto& handles = m_context->handles;
+            m_passes.erase(pass);
+        }
+    }
+
+    void vulkan_evaluator::destroy_pass(vulkan_pass_data_t& pass) {
+        ZoneScoped;
+
+        const auto& v = m_context->vtable;
+        const auto& handles = m_context->handles;
 
-            v.check_result(v.vkFreeDescriptorSets(handles.device, m_objects.descriptor_pool, 1,
-                                                  &data.descriptor_set));
+        v.check_result(v.vkFreeDescriptorSets(handles.device, m_objects.descriptor_pool, 1,
+                                              &pass.descriptor_set));
 
-            destroy_vulkan_image(m_context.get(), &data.activations);
-            destroy_vulkan_image(m_context.get(), &data.z);
-            destroy_vulkan_image(m_context.get(), &data.deltas);
+        destroy_vulkan_image(m_context.get(), &pass.activations);
+        destroy_vulkan_image(m_context.get(), &pass.z);
+        destroy_vulkan_image(m_context.get(), &pass.deltas);
 
-            m_passes.erase(pass);
+        if (pass.eval_commands != VK_NULL_HANDLE) {
+            std::vector<VkCommandBuffer> command_buffers = { pass.eval_commands,
+                                                             pass.backprop_commands };
+
+            v.vkFreeCommandBuffers(handles.device, m_objects.command_pool,
+                                   (uint32_t)command_buffers.size(), command_buffers.data());
+
+            v.vkDestroyFence(handles.device, pass.eval_fence, &v.alloc_callbacks);
+            v.vkDestroyFence(handles.device, pass.backprop_fence, &v.alloc_callbacks);
+
+            destroy_vulkan_buffer(m_context.get(), &pass.inputs);
+            destroy_vulkan_buffer(m_context.get(), &pass.expected_outputs);
         }
     }
 
-    uint64_t vulkan_evaluator::new_pass(const network* network,
-                                        const std::vector<number_t>& inputs) {
+    uint64_t vulkan_evaluator::create_pass(const network* network, size_t run_count) {
         ZoneScoped;
         add_network_reference(network);
         const auto& layers = network->get_layers();
 
-        uint64_t input_neurons = layers[0].previous_size;
-        size_t input_count = inputs.size();
-
         uint64_t id = m_current_pass_id++;
         auto& pass = m_passes[id];
 
         pass.references = 1;
         pass.nn = network;
         pass.pass_id = id;
-        pass.run_count = (input_count - (input_count % input_neurons)) / input_neurons;
+        pass.run_count = run_count;
+
+        pass.plan = nullptr;
+        pass.eval_commands = pass.backprop_commands = VK_NULL_HANDLE;
+        pass.eval_fence = pass.backprop_fence = VK_NULL_HANDLE;
+        pass.backprop_pending = false;
 
         uint64_t max_neurons = 0;
         uint64_t max_neuron_size = 0;
@@ -1813,17 +2018,75 @@ namespace neuralnet::evaluators {
         std::vector<VkDescriptorImageInfo> image_info(descriptor_images.size());
         std::vector<VkWriteDescriptorSet> writes(descriptor_images.size());
 
+        for (size_t i = 0; i < descriptor_images.size(); i++) {
+            auto image = descriptor_images[i];
+
+            auto& info = image_info[i];
+            info.sampler = VK_NULL_HANDLE;
+            info.imageLayout = image_compute_layout;
+            info.imageView = image->view;
+
+            auto& write = writes[i];
+            std::memset(&write, 0, sizeof(VkWriteDescriptorSet));
+
+            write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            write.descriptorCount = 1;
+            write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
+            write.dstSet = pass.descriptor_set;
+            write.dstBinding = (uint32_t)i;
+            write.dstArrayElement = 0;
+            write.pImageInfo = &info;
+        }
+
+        const auto& v = m_context->vtable;
+        const auto& handles = m_context->handles;
+
+        v.vkUpdateDescriptorSets(handles.device, (uint32_t)writes.size(), writes.data(), 0,
+                                 nullptr);
+
+        return id;
+    }
+
+    // copies every run's inputs from a staging buffer into the first row of the activations
+    static void get_input_regions(std::vector<VkBufferImageCopy>& regions, size_t run_count,
+                                  uint64_t input_neurons) {
+        ZoneScoped;
+
+        regions.clear();
+        for (size_t i = 0; i < run_count; i++) {
+            auto& region = regions.emplace_back();
+            std::memset(&region, 0, sizeof(VkBufferImageCopy));
+
+            region.imageExtent.width = (uint32_t)input_neurons;
+            region.imageExtent.height = 1;
+            region.imageExtent.depth = 1;
+            region.imageOffset.z = (int32_t)i;
+            region.bufferOffset = (VkDeviceSize)(i * input_neurons * sizeof(number_t));
+            region.imageSubresource.aspectMask = image_aspect_flags;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = 1;
+            region.imageSubresource.mipLevel = 0;
+        }
+    }
+
+    uint64_t vulkan_evaluator::new_pass(const network* network,
+                                        const std::vector<number_t>& inputs) {
+        ZoneScoped;
+
+        uint64_t input_neurons = network->get_layers()[0].previous_size;
+        size_t input_count = inputs.size();
+        size_t run_count = (input_count - (input_count % input_neurons)) / input_neurons;
+
+        uint64_t id = create_pass(network, run_count);
+        auto& pass = m_passes[id];
+
         vulkan_buffer_t staging_buffer;
         create_vulkan_buffer(m_context.get(), inputs.size() * sizeof(number_t), &staging_buffer);
+        write_staging_buffer(m_context.get(), staging_buffer, inputs.data(), staging_buffer.size);
 
         const auto& v = m_context->vtable;
         const auto& handles = m_context->handles;
 
-        void* mapped = nullptr;
-        vmaMapMemory(handles.allocator, staging_buffer.allocation, &mapped);
-        copy(inputs.data(), mapped, staging_buffer.size);
-        vmaUnmapMemory(handles.allocator, staging_buffer.allocation);
-
         VkCommandBuffer command_buffer =
             alloc_open_command_buffer(m_context.get(), m_objects.command_pool);
 
@@ -1842,20 +2105,7 @@ namespace neuralnet::evaluators {
                                    transfer_stage, 0, 0, nullptr, 0, nullptr, 1, &src_barrier);
 
             std::vector<VkBufferImageCopy> regions;
-            for (size_t i = 0; i < pass.run_count; i++) {
-                auto& region = regions.emplace_back();
-                std::memset(&region, 0, sizeof(VkBufferImageCopy));
-
-                region.imageExtent.width = (uint32_t)input_neurons;
-                region.imageExtent.height = 1;
-                region.imageExtent.depth = 1;
-                region.imageOffset.z = (int32_t)i;
-                region.bufferOffset = (VkDeviceSize)(i * input_neurons * sizeof(number_t));
-                region.imageSubresource.aspectMask = image_aspect_flags;
-                region.imageSubresource.baseArrayLayer = 0;
-                region.imageSubresource.layerCount = 1;
-                region.imageSubresource.mipLevel = 0;
-            }
+            get_input_regions(regions, pass.run_count, input_neurons);
 
             v.vkCmdCopyBufferToImage(command_buffer, staging_buffer.buffer, pass.activations.image,
                                      transfer_dst_layout, (uint32_t)regions.size(), regions.data());
@@ -1863,38 +2113,142 @@ namespace neuralnet::evaluators {
             v.vkCmdPipelineBarrier(command_buffer, transfer_stage, compute_stage, 0, 0, nullptr, 0,
                                    nullptr, 1, &dst_barrier);
 
-            for (size_t i = 0; i < descriptor_images.size(); i++) {
-                auto image = descriptor_images[i];
-                if (image != &pass.activations) {
-                    initialize_image(m_context.get(), command_buffer, image->image);
-                }
+            initialize_image(m_context.get(), command_buffer, pass.z.image);
+            initialize_image(m_context.get(), command_buffer, pass.deltas.image);
+        }
 
-                auto& info = image_info[i];
-                info.sampler = VK_NULL_HANDLE;
-                info.imageLayout = image_compute_layout;
-                info.imageView = image->view;
-
-                auto& write = writes[i];
-                std::memset(&write, 0, sizeof(VkWriteDescriptorSet));
-
-                write.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                write.descriptorCount = 1;
-                write.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
-                write.dstSet = pass.descriptor_set;
-                write.dstBinding = (uint32_t)i;
-                write.dstArrayElement = 0;
-                write.pImageInfo = &info;
-            }
+        end_and_submit_command_buffer(m_context.get(), m_objects.compute_queue, command_buffer,
+                                      true, VK_NULL_HANDLE);
+
+        v.vkFreeCommandBuffers(handles.device, m_objects.command_pool, 1, &command_buffer);
+        destroy_vulkan_buffer(m_context.get(), &staging_buffer);
+
+        return id;
+    }
+
+    uint64_t vulkan_evaluator::acquire_pass(vulkan_execution_plan_t& plan) {
+        ZoneScoped;
+
+        if (!plan.idle_passes.empty()) {
+            uint64_t id = plan.idle_passes.back();
+            plan.idle_passes.pop_back();
+
+            m_passes.at(id).references = 1;
+            return id;
         }
 
+        uint64_t id = create_pass(plan.nn, plan.run_count);
+        plan.passes.push_back(id);
+
+        auto& pass = m_passes.at(id);
+        pass.plan = &plan;
+
+        const auto& layers = plan.nn->get_layers();
+        uint64_t input_neurons = layers[0].previous_size;
+        uint64_t output_count = layers[layers.size() - 1].size;
+
+        create_vulkan_buffer(m_context.get(), input_neurons * plan.run_count * sizeof(number_t),
+                             &pass.inputs);
+
+        create_vulkan_buffer(m_context.get(), output_count * plan.run_count * sizeof(number_t),
+                             &pass.expected_outputs);
+
+        const auto& v = m_context->vtable;
+        const auto& handles = m_context->handles;
+
+        VkFenceCreateInfo fence_info{};
+        fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+
+        v.check_result(
+            v.vkCreateFence(handles.device, &fence_info, &v.alloc_callbacks, &pass.eval_fence));
+        v.check_result(
+            v.vkCreateFence(handles.device, &fence_info, &v.alloc_callbacks, &pass.backprop_fence));
+
+        // images only leave the compute layout while the recorded commands copy into them
+        VkCommandBuffer command_buffer =
+            alloc_open_command_buffer(m_context.get(), m_objects.command_pool);
+
+        initialize_image(m_context.get(), command_buffer, pass.activations.image);
+        initialize_image(m_context.get(), command_buffer, pass.z.image);
+        initialize_image(m_context.get(), command_buffer, pass.deltas.image);
+
         end_and_submit_command_buffer(m_context.get(), m_objects.compute_queue, command_buffer,
                                       true, VK_NULL_HANDLE);
 
         v.vkFreeCommandBuffers(handles.device, m_objects.command_pool, 1, &command_buffer);
-        v.vkUpdateDescriptorSets(handles.device, (uint32_t)writes.size(), writes.data(), 0,
-                                 nullptr);
 
-        destroy_vulkan_buffer(m_context.get(), &staging_buffer);
+        // recorded without gpu profiler zones, as those cannot be submitted more than once
+        VkImageMemoryBarrier src_barrier, dst_barrier;
+        create_image_barrier(src_barrier, pass.activations.image, image_access_flags,
+                             transfer_dst_access, image_compute_layout, transfer_dst_layout);
+        create_image_barrier(dst_barrier, pass.activations.image, transfer_dst_access,
+                             image_access_flags, transfer_dst_layout, image_compute_layout);
+
+        std::vector<VkBufferImageCopy> regions;
+        get_input_regions(regions, plan.run_count, input_neurons);
+
+        pass.eval_commands = alloc_open_command_buffer(m_context.get(), m_objects.command_pool);
+        v.vkCmdPipelineBarrier(pass.eval_commands, compute_stage, transfer_stage, 0, 0, nullptr, 0,
+                               nullptr, 1, &src_barrier);
+
+        v.vkCmdCopyBufferToImage(pass.eval_commands, pass.inputs.buffer, pass.activations.image,
+                                 transfer_dst_layout, (uint32_t)regions.size(), regions.data());
+
+        v.vkCmdPipelineBarrier(pass.eval_commands, transfer_stage, compute_stage, 0, 0, nullptr, 0,
+                               nullptr, 1, &dst_barrier);
+
+        record_eval(pass.eval_commands, pass);
+        v.check_result(v.vkEndCommandBuffer(pass.eval_commands));
+
+        pass.backprop_commands = alloc_open_command_buffer(m_context.get(), m_objects.command_pool);
+        record_backprop(pass.backprop_commands, pass, pass.expected_outputs);
+        v.check_result(v.vkEndCommandBuffer(pass.backprop_commands));
+
         return id;
     }
+
+    bool vulkan_evaluator::compile_plan(const network* nn, uint64_t batch_size) {
+        ZoneScoped;
+
+        if (nn->get_layers().empty() || batch_size == 0) {
+            return false;
+        }
+
+        auto key = std::make_tuple(nn, (size_t)batch_size);
+        if (m_plans.contains(key)) {
+            return true;
+        }
+
+        auto& plan = m_plans[key];
+        plan.nn = nn;
+        plan.run_count = (size_t)batch_size;
+
+        // make the first pass now, rather than during the first evaluation
+        remove_pass_reference(acquire_pass(plan));
+        return true;
+    }
+
+    void vulkan_evaluator::release_plans(const network* nn) {
+        ZoneScoped;
+
+        for (auto it = m_plans.begin(); it != m_plans.end();) {
+            if (std::get<0>(it->first) != nn) {
+                it++;
+                continue;
+            }
+
+            // referenced passes are destroyed as usual once their results are freed
+            auto& plan = it->second;
+            for (uint64_t pass : plan.passes) {
+                m_passes.at(pass).plan = nullptr;
+            }
+
+            for (uint64_t pass : plan.idle_passes) {
+                m_passes.at(pass).references = 1;
+                remove_pass_reference(pass);
+            }
+
+            it = m_plans.erase(it);
+        }
+    }
 } // namespace neuralnet::evaluators
\ No newline at end of file
@@ -0,0 +1,315 @@
+#include "nnpch.h"
+#include "neuralnet/factorization.h"
+
+namespace neuralnet {
+    void singular_value_decomposition(const number_t* matrix, uint64_t rows, uint64_t columns,
+                                      std::vector<double>& u, std::vector<double>& sigma,
+                                      std::vector<double>& vt) {
+        ZoneScoped;
+
+        // rotating pairs of rows until all of them are orthogonal leaves b = q^T * matrix, where
+        // q accumulates the rotations. row i of b is then sigma_i * v_i^T, and q is u
+        std::vector<double> b(matrix, matrix + rows * columns);
+        std::vector<double> qt(rows * rows, 0);
+
+        for (uint64_t i = 0; i < rows; i++) {
+            qt[i * rows + i] = 1;
+        }
+
+        static constexpr double tolerance = 1e-12;
+        static constexpr uint32_t max_sweeps = 64;
+
+        for (uint32_t sweep = 0; sweep < max_sweeps; sweep++) {
+            bool rotated = false;
+
+            for (uint64_t i = 0; i + 1 < rows; i++) {
+                double* bi = &b[i * columns];
+                double* qi = &qt[i * rows];
+
+                for (uint64_t j = i + 1; j < rows; j++) {
+                    double* bj = &b[j * columns];
+                    double* qj = &qt[j * rows];
+
+                    double alpha = 0, beta = 0, gamma = 0;
+                    for (uint64_t k = 0; k < columns; k++) {
+                        alpha += bi[k] * bi[k];
+                        beta += bj[k] * bj[k];
+                        gamma += bi[k] * bj[k];
+                    }
+
+                    if (std::abs(gamma) <= tolerance * std::sqrt(alpha * beta)) {
+                        continue;
+                    }
+
+                    // the rotation that zeroes gamma, taking the smaller of the two angles
+                    double zeta = (beta - alpha) / (2 * gamma);
+                    double t = (zeta >= 0 ? 1 : -1) / (std::abs(zeta) + std::sqrt(1 + zeta * zeta));
+                    double c = 1 / std::sqrt(1 + t * t);
+                    double s = c * t;
+
+                    for (uint64_t k = 0; k < columns; k++) {
+                        double x = bi[k], y = bj[k];
+                        bi[k] = c * x - s * y;
+                        bj[k] = s * x + c * y;
+                    }
+
+                    for (uint64_t k = 0; k < rows; k++) {
+                        double x = qi[k], y = qj[k];
+                        qi[k] = c * x - s * y;
+                        qj[k] = s * x + c * y;
+                    }
+
+                    rotated = true;
+                }
+            }
+
+            if (!rotated) {
+                break;
+            }
+        }
+
+        std::vector<double> norms(rows);
+        std::vector<uint64_t> order(rows);
+
+        for (uint64_t i = 0; i < rows; i++) {
+            double sum = 0;
+            for (uint64_t k = 0; k < columns; k++) {
+                sum += b[i * columns + k] * b[i * columns + k];
+            }
+
+            norms[i] = std::sqrt(sum);
+            order[i] = i;
+        }
+
+        std::stable_sort(order.begin(), order.end(),
+                         [&](uint64_t lhs, uint64_t rhs) { return norms[lhs] > norms[rhs]; });
+
+        u.assign(rows * rows, 0);
+        sigma.resize(rows);
+        vt.assign(rows * columns, 0);
+
+        double largest = rows > 0 ? norms[order[0]] : 0;
+        for (uint64_t r = 0; r < rows; r++) {
+            uint64_t i = order[r];
+            sigma[r] = norms[i];
+
+            for (uint64_t k = 0; k < rows; k++) {
+                u[k * rows + r] = qt[i * rows + k];
+            }
+
+            // directions past the matrix's numerical rank carry nothing but rounding error
+            if (norms[i] > largest * 1e-15) {
+                for (uint64_t k = 0; k < columns; k++) {
+                    vt[r * columns + k] = b[i * columns + k] / norms[i];
+                }
+            } else {
+                sigma[r] = 0;
+            }
+        }
+    }
+
+    static uint64_t choose_rank(const std::vector<double>& sigma,
+                                const factorization_settings_t& settings) {
+        if (settings.rank > 0) {
+            return std::min<uint64_t>(settings.rank, sigma.size());
+        }
+
+        double total = 0;
+        for (double value : sigma) {
+            total += value * value;
+        }
+
+        double kept = 0;
+        for (uint64_t rank = 0; rank < sigma.size(); rank++) {
+            kept += sigma[rank] * sigma[rank];
+            if (kept >= settings.energy * total) {
+                return rank + 1;
+            }
+        }
+
+        return sigma.size();
+    }
+
+    factorized_network* factorized_network::factorize(const network* nn,
+                                                      const factorization_settings_t& settings) {
+        ZoneScoped;
+
+        if (settings.rank == 0 && (settings.energy <= 0 || settings.energy > 1)) {
+            throw std::runtime_error("energy must lie within (0, 1]!");
+        }
+
+        const auto& layers = nn->get_layers();
+        std::vector<factorized_layer_t> factorized_layers(layers.size());
+        std::vector<double> u, sigma, vt;
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            auto& factorized = factorized_layers[i];
+
+            factorized.size = layer.size;
+            factorized.previous_size = layer.previous_size;
+            factorized.function = layer.function;
+            factorized.biases = layer.biases;
+
+            // the largest rank that still costs fewer multiply-adds than the dense layer
+            uint64_t break_even =
+                (layer.size * layer.previous_size - 1) / (layer.size + layer.previous_size);
+
+            singular_value_decomposition(layer.weights.data(), layer.size, layer.previous_size, u,
+                                         sigma, vt);
+
+            uint64_t rank = choose_rank(sigma, settings);
+            if (rank == 0 || rank > break_even) {
+                factorized.rank = 0;
+                factorized.weights = layer.weights;
+
+                continue;
+            }
+
+            // singular values are folded into down
+            factorized.rank = rank;
+            factorized.down.resize(rank * layer.previous_size);
+            factorized.up.resize(layer.size * rank);
+
+            for (uint64_t r = 0; r < rank; r++) {
+                for (uint64_t p = 0; p < layer.previous_size; p++) {
+                    double value = sigma[r] * vt[r * layer.previous_size + p];
+                    factorized.down[r * layer.previous_size + p] = (number_t)value;
+                }
+            }
+
+            for (uint64_t c = 0; c < layer.size; c++) {
+                for (uint64_t r = 0; r < rank; r++) {
+                    factorized.up[c * rank + r] = (number_t)u[c * layer.size + r];
+                }
+            }
+        }
+
+        return new factorized_network(factorized_layers);
+    }
+
+    factorized_network::factorized_network(const std::vector<factorized_layer_t>& layers) {
+        ZoneScoped;
+        m_layers = layers;
+    }
+
+    uint64_t factorized_network::get_multiply_adds() const {
+        uint64_t count = 0;
+        for (const auto& layer : m_layers) {
+            if (layer.rank > 0) {
+                count += layer.rank * (layer.size + layer.previous_size);
+            } else {
+                count += layer.size * layer.previous_size;
+            }
+        }
+
+        return count;
+    }
+
+    // y = matrix (rows x columns) * x, plus bias if it is not null
+    static void multiply(const number_t* matrix, const number_t* x, const number_t* bias,
+                         number_t* y, uint64_t rows, uint64_t columns) {
+        for (uint64_t r = 0; r < rows; r++) {
+            number_t sum = bias != nullptr ? bias[r] : 0;
+            const number_t* row = &matrix[r * columns];
+
+            for (uint64_t c = 0; c < columns; c++) {
+                sum += row[c] * x[c];
+            }
+
+            y[r] = sum;
+        }
+    }
+
+    static size_t find_largest(const std::vector<number_t>& values) {
+        return (size_t)(std::max_element(values.begin(), values.end()) - values.begin());
+    }
+
+    factorization_report_t factorized_network::compare(const network* nn, const dataset* data,
+                                                       dataset_group group) const {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        if (layers.size() != m_layers.size()) {
+            throw std::runtime_error("network mismatch!");
+        }
+
+        factorization_report_t report;
+        report.samples = 0;
+        report.dense_multiply_adds = 0;
+        report.factorized_multiply_adds = get_multiply_adds();
+        report.max_error = 0;
+
+        for (const auto& layer : layers) {
+            report.dense_multiply_adds += layer.size * layer.previous_size;
+        }
+
+        uint64_t dense_correct = 0, factorized_correct = 0;
+        std::vector<number_t> inputs, expected, dense, factorized, projected, next;
+
+        uint64_t sample_count = data->get_sample_count(group);
+        for (uint64_t sample = 0; sample < sample_count; sample++) {
+            if (!data->get_sample(group, sample, inputs, expected)) {
+                continue;
+            }
+
+            if (inputs.size() != layers[0].previous_size) {
+                throw std::runtime_error("input count mismatch!");
+            }
+
+            dense = inputs;
+            factorized = inputs;
+
+            for (size_t i = 0; i < layers.size(); i++) {
+                const auto& layer = layers[i];
+                const auto& factorized_layer = m_layers[i];
+
+                next.resize(layer.size);
+                multiply(layer.weights.data(), dense.data(), layer.biases.data(), next.data(),
+                         layer.size, layer.previous_size);
+
+                activate(layer.function, next.data(), next.size());
+
+                dense.swap(next);
+                next.resize(layer.size);
+
+                if (factorized_layer.rank > 0) {
+                    projected.resize(factorized_layer.rank);
+                    multiply(factorized_layer.down.data(), factorized.data(), nullptr,
+                             projected.data(), factorized_layer.rank, layer.previous_size);
+
+                    multiply(factorized_layer.up.data(), projected.data(),
+                             factorized_layer.biases.data(), next.data(), layer.size,
+                             factorized_layer.rank);
+                } else {
+                    multiply(factorized_layer.weights.data(), factorized.data(),
+                             factorized_layer.biases.data(), next.data(), layer.size,
+                             layer.previous_size);
+                }
+
+                activate(factorized_layer.function, next.data(), next.size());
+
+                factorized.swap(next);
+            }
+
+            size_t label = find_largest(expected);
+            dense_correct += find_largest(dense) == label ? 1 : 0;
+            factorized_correct += find_largest(factorized) == label ? 1 : 0;
+
+            for (size_t c = 0; c < dense.size(); c++) {
+                report.max_error = std::max(report.max_error, std::abs(dense[c] - factorized[c]));
+            }
+
+            report.samples++;
+        }
+
+        if (report.samples > 0) {
+            report.dense_accuracy = (double)dense_correct / report.samples;
+            report.factorized_accuracy = (double)factorized_correct / report.samples;
+        } else {
+            report.dense_accuracy = report.factorized_accuracy = 0;
+        }
+
+        return report;
+    }
+} // namespace neuralnet
\ No newline at end of file
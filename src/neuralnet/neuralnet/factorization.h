@@ -0,0 +1,81 @@
+#pragma once
+#include "neuralnet/network.h"
+#include "neuralnet/trainer.h"
+
+namespace neuralnet {
+    // low-rank copy of a layer, for inference only
+    // the weights are approximated by up * down, where down (rank x previous_size) projects the
+    // inputs onto the layer's leading singular directions and up (size x rank) maps them back.
+    // that costs rank * (size + previous_size) multiply-adds instead of size * previous_size
+    struct factorized_layer_t {
+        uint64_t size;
+        uint64_t previous_size;
+        activation_function function;
+
+        // 0 if factoring would not have saved anything; the layer is then kept dense, in weights
+        uint64_t rank;
+
+        // both row-major, like layer_t::weights
+        std::vector<number_t> down, up;
+        std::vector<number_t> weights;
+
+        std::vector<number_t> biases;
+    };
+
+    struct factorization_settings_t {
+        // rank every layer is truncated to. 0 picks each layer's rank by energy instead
+        uint64_t rank;
+
+        // smallest fraction (0-1] of the sum of a layer's squared singular values to keep
+        double energy;
+    };
+
+    // full precision and factorized networks, evaluated on the same samples
+    struct factorization_report_t {
+        uint64_t samples;
+
+        // per sample
+        uint64_t dense_multiply_adds, factorized_multiply_adds;
+
+        // fraction of samples whose largest output matches the largest expected output
+        double dense_accuracy, factorized_accuracy;
+
+        // between the outputs of both networks
+        number_t max_error;
+    };
+
+    class NN_API factorized_network {
+    public:
+        // factors every layer's weights with a truncated singular value decomposition. layers
+        // are truncated to rank * (size + previous_size) < size * previous_size at most
+        static factorized_network* factorize(const network* nn,
+                                             const factorization_settings_t& settings);
+
+        factorized_network(const std::vector<factorized_layer_t>& layers);
+        ~factorized_network() = default;
+
+        factorized_network(const factorized_network&) = delete;
+        factorized_network& operator=(const factorized_network&) = delete;
+
+        const std::vector<factorized_layer_t>& get_layers() const { return m_layers; }
+
+        // per sample, over every layer
+        uint64_t get_multiply_adds() const;
+
+        // compares this network with the one it was factored from, on every sample of a group
+        factorization_report_t compare(const network* nn, const dataset* data,
+                                       dataset_group group) const;
+
+    private:
+        std::vector<factorized_layer_t> m_layers;
+    };
+
+    // singular value decomposition of a row-major (rows x columns) matrix, by one-sided jacobi
+    // rotations in double precision. on return, matrix = u * diag(sigma) * v^T, with sigma in
+    // descending order. u is (rows x rows) and v^T (rows x columns), both row-major; rows past the
+    // matrix's rank are zero in v^T
+    NN_API void singular_value_decomposition(const number_t* matrix, uint64_t rows,
+                                             uint64_t columns, std::vector<double>& u,
+                                             std::vector<double>& sigma,
+                                             std::vector<double>& vt);
+} // namespace neuralnet
\ No newline at end of file
@@ -2,18 +2,29 @@
 #include "neuralnet/loader.h"
 #include "neuralnet/util.h"
 #include "neuralnet/compression.h"
+#include "neuralnet/sparsity.h"
 
 #include <nlohmann/json.hpp>
 using json = nlohmann::json;
 
 namespace neuralnet {
+    // how a layer's weights are laid out in its data file, after the biases
+    //   dense: size * previous_size parameters, row by row
+    //   csr: size + 1 row offsets and nnz column indices (uint32), then nnz parameters, see
+    //   basic_sparse_weights_t
+    enum class serialized_weights { dense, csr };
+
     struct layer_desc_t {
         fs::path path;
         uint64_t size;
         activation_function function;
+        serialized_weights weights;
     };
 
+    enum class serialized_precision { float32, float64 };
+
     struct network_desc_t {
+        serialized_precision precision;
         uint64_t input_count;
         std::vector<layer_desc_t> layers;
     };
@@ -25,11 +36,28 @@ namespace neuralnet {
         src["size"].get_to(dst.size);
 
         static const std::unordered_map<std::string, activation_function> function_map = {
-            { "sigmoid", activation_function::sigmoid }
+            { "sigmoid", activation_function::sigmoid },
+            { "relu", activation_function::relu },
+            { "leaky_relu", activation_function::leaky_relu },
+            { "tanh", activation_function::tanh },
+            { "gelu", activation_function::gelu },
+            { "identity", activation_function::identity },
+            { "softmax", activation_function::softmax }
         };
 
         auto function_name = src["function"].get<std::string>();
         dst.function = function_map.at(function_name);
+
+        // layers saved before sparse weights were supported are dense
+        dst.weights = serialized_weights::dense;
+        if (src.contains("weights")) {
+            static const std::unordered_map<std::string, serialized_weights> weights_map = {
+                { "dense", serialized_weights::dense }, { "csr", serialized_weights::csr }
+            };
+
+            auto weights_name = src["weights"].get<std::string>();
+            dst.weights = weights_map.at(weights_name);
+        }
     }
 
     void to_json(json& dst, const layer_desc_t& src) {
@@ -43,16 +71,47 @@ namespace neuralnet {
         case activation_function::sigmoid:
             function_name = "sigmoid";
             break;
+        case activation_function::relu:
+            function_name = "relu";
+            break;
+        case activation_function::leaky_relu:
+            function_name = "leaky_relu";
+            break;
+        case activation_function::tanh:
+            function_name = "tanh";
+            break;
+        case activation_function::gelu:
+            function_name = "gelu";
+            break;
+        case activation_function::identity:
+            function_name = "identity";
+            break;
+        case activation_function::softmax:
+            function_name = "softmax";
+            break;
         default:
             throw std::runtime_error("invalid activation function!");
         }
 
         dst["function"] = function_name;
+        dst["weights"] = src.weights == serialized_weights::csr ? "csr" : "dense";
     }
 
     void from_json(const json& src, network_desc_t& dst) {
         ZoneScoped;
 
+        // networks saved before precision was recorded are single precision
+        dst.precision = serialized_precision::float32;
+        if (src.contains("precision")) {
+            static const std::unordered_map<std::string, serialized_precision> precision_map = {
+                { "float", serialized_precision::float32 },
+                { "double", serialized_precision::float64 }
+            };
+
+            auto precision_name = src["precision"].get<std::string>();
+            dst.precision = precision_map.at(precision_name);
+        }
+
         src["input_count"].get_to(dst.input_count);
         src["layers"].get_to(dst.layers);
     }
@@ -60,11 +119,13 @@ namespace neuralnet {
     void to_json(json& dst, const network_desc_t& src) {
         ZoneScoped;
 
+        dst["precision"] = src.precision == serialized_precision::float64 ? "double" : "float";
         dst["input_count"] = src.input_count;
         dst["layers"] = src.layers;
     }
 
-    loader::loader(const fs::path& directory) {
+    template <typename _Ty>
+    basic_loader<_Ty>::basic_loader(const fs::path& directory) {
         ZoneScoped;
 
         m_directory = directory;
@@ -78,30 +139,80 @@ namespace neuralnet {
     }
 
     static constexpr std::endian serialization_endianness = std::endian::little;
-    static number_t read_number(file_decompressor& file, std::vector<uint8_t>& buffer) {
+    template <typename _Ty>
+    static _Ty read_number(file_decompressor& file, std::vector<uint8_t>& buffer) {
         ZoneScoped;
-        if (buffer.size() < sizeof(number_t)) {
-            buffer.resize(sizeof(number_t));
+        if (buffer.size() < sizeof(_Ty)) {
+            buffer.resize(sizeof(_Ty));
         }
 
-        number_t result;
-        file.read(buffer.data(), sizeof(number_t));
+        _Ty result;
+        file.read(buffer.data(), sizeof(_Ty));
 
         read_with_endianness<serialization_endianness>(buffer.data(), result);
         return result;
     }
 
-    static void write_number(file_compressor& file, number_t value, std::vector<uint8_t>& buffer) {
+    template <typename _Ty>
+    static void write_number(file_compressor& file, _Ty value, std::vector<uint8_t>& buffer) {
         ZoneScoped;
-        if (buffer.size() < sizeof(number_t)) {
-            buffer.resize(sizeof(number_t));
+        if (buffer.size() < sizeof(_Ty)) {
+            buffer.resize(sizeof(_Ty));
         }
 
         write_with_endianness<serialization_endianness>(value, buffer.data());
-        file.write(buffer.data(), sizeof(number_t));
+        file.write(buffer.data(), sizeof(_Ty));
+    }
+
+    // reads a parameter stored in the given precision, converted to _Ty
+    template <typename _Ty>
+    static _Ty read_parameter(file_decompressor& file, serialized_precision precision,
+                              std::vector<uint8_t>& buffer) {
+        switch (precision) {
+        case serialized_precision::float32:
+            return (_Ty)read_number<float>(file, buffer);
+        case serialized_precision::float64:
+            return (_Ty)read_number<double>(file, buffer);
+        default:
+            throw std::runtime_error("invalid precision!");
+        }
+    }
+
+    template <typename _Ty>
+    static void read_sparse_weights(file_decompressor& file, serialized_precision precision,
+                                    std::vector<uint8_t>& buffer,
+                                    basic_sparse_weights_t<_Ty>& sparse) {
+        ZoneScoped;
+
+        sparse.offsets.resize(sparse.rows + 1);
+        for (uint64_t c = 0; c <= sparse.rows; c++) {
+            sparse.offsets[c] = read_number<uint32_t>(file, buffer);
+            if (c > 0 ? sparse.offsets[c] < sparse.offsets[c - 1] : sparse.offsets[c] != 0) {
+                throw std::runtime_error("invalid sparse row offsets!");
+            }
+        }
+
+        uint32_t count = sparse.offsets[sparse.rows];
+        if (count > sparse.rows * sparse.columns) {
+            throw std::runtime_error("invalid sparse row offsets!");
+        }
+
+        sparse.indices.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            sparse.indices[i] = read_number<uint32_t>(file, buffer);
+            if (sparse.indices[i] >= sparse.columns) {
+                throw std::runtime_error("sparse column index out of range!");
+            }
+        }
+
+        sparse.values.resize(count);
+        for (uint32_t i = 0; i < count; i++) {
+            sparse.values[i] = read_parameter<_Ty>(file, precision, buffer);
+        }
     }
 
-    bool loader::load_from_file() {
+    template <typename _Ty>
+    bool basic_loader<_Ty>::load_from_file() {
         ZoneScoped;
         if (m_network) {
             return false;
@@ -119,8 +230,9 @@ namespace neuralnet {
         network_desc_t network_desc;
         desc.get_to(network_desc);
 
-        std::vector<layer_t> layers(network_desc.layers.size());
+        std::vector<typename network_type::layer_type> layers(network_desc.layers.size());
         std::vector<uint8_t> buffer;
+        basic_sparse_weights_t<_Ty> sparse;
 
         for (size_t i = 0; i < layers.size(); i++) {
             auto& layer = layers[i];
@@ -141,19 +253,30 @@ namespace neuralnet {
 
             file_decompressor data_file(data_file_path);
             for (uint64_t b = 0; b < layer.size; b++) {
-                layer.biases[b] = read_number(data_file, buffer);
+                layer.biases[b] = read_parameter<_Ty>(data_file, network_desc.precision, buffer);
+            }
+
+            if (layer_desc.weights == serialized_weights::csr) {
+                sparse.rows = layer.size;
+                sparse.columns = layer.previous_size;
+
+                read_sparse_weights(data_file, network_desc.precision, buffer, sparse);
+                expand_weights(sparse, layer);
+
+                continue;
             }
 
             for (uint64_t w = 0; w < layer.size * layer.previous_size; w++) {
-                layer.weights[w] = read_number(data_file, buffer);
+                layer.weights[w] = read_parameter<_Ty>(data_file, network_desc.precision, buffer);
             }
         }
 
-        m_network = unique(new network(layers));
+        m_network = unique(new network_type(layers));
         return true;
     }
 
-    bool loader::save_to_file() {
+    template <typename _Ty>
+    bool basic_loader<_Ty>::save_to_file() {
         ZoneScoped;
         if (!m_network) {
             return false;
@@ -165,10 +288,15 @@ namespace neuralnet {
         }
 
         network_desc_t desc;
+        desc.precision = std::is_same_v<_Ty, double> ? serialized_precision::float64
+                                                     : serialized_precision::float32;
+
         desc.input_count = layers[0].previous_size;
         desc.layers.resize(layers.size());
 
         std::vector<uint8_t> buffer;
+        basic_sparse_weights_t<_Ty> sparse;
+
         for (size_t i = 0; i < layers.size(); i++) {
             const auto& layer = layers[i];
             auto& layer_descs = desc.layers[i];
@@ -177,13 +305,42 @@ namespace neuralnet {
             layer_descs.size = layer.size;
             layer_descs.path = std::to_string(i) + ".dat";
 
+            // pruned layers are stored compressed, if that takes fewer bytes than storing them
+            // densely
+            auto zero = (uint64_t)std::count(layer.weights.begin(), layer.weights.end(), (_Ty)0);
+            uint64_t non_zero = layer.weights.size() - zero;
+
+            uint64_t dense_size = layer.weights.size() * sizeof(_Ty);
+            uint64_t csr_size =
+                (layer.size + 1) * sizeof(uint32_t) + non_zero * (sizeof(uint32_t) + sizeof(_Ty));
+
+            bool compressed = csr_size < dense_size &&
+                              layer.weights.size() <= std::numeric_limits<uint32_t>::max();
+
+            layer_descs.weights = compressed ? serialized_weights::csr : serialized_weights::dense;
+
             file_compressor data_file(m_directory / layer_descs.path);
             for (size_t b = 0; b < layer.biases.size(); b++) {
                 write_number(data_file, layer.biases[b], buffer);
             }
 
-            for (size_t w = 0; w < layer.weights.size(); w++) {
-                write_number(data_file, layer.weights[w], buffer);
+            if (compressed) {
+                compress_weights(layer, sparse);
+                for (uint32_t offset : sparse.offsets) {
+                    write_number(data_file, offset, buffer);
+                }
+
+                for (uint32_t index : sparse.indices) {
+                    write_number(data_file, index, buffer);
+                }
+
+                for (_Ty value : sparse.values) {
+                    write_number(data_file, value, buffer);
+                }
+            } else {
+                for (size_t w = 0; w < layer.weights.size(); w++) {
+                    write_number(data_file, layer.weights[w], buffer);
+                }
             }
         }
 
@@ -196,7 +353,8 @@ namespace neuralnet {
         return true;
     }
 
-    bool loader::load_from_memory(network* nn) {
+    template <typename _Ty>
+    bool basic_loader<_Ty>::load_from_memory(network_type* nn) {
         ZoneScoped;
         if (m_network) {
             return false;
@@ -205,4 +363,7 @@ namespace neuralnet {
         m_network = unique(nn);
         return true;
     }
+
+    template class NN_API basic_loader<float>;
+    template class NN_API basic_loader<double>;
 } // namespace neuralnet
\ No newline at end of file
@@ -2,32 +2,42 @@
 #include "neuralnet/network.h"
 
 namespace neuralnet {
-    class loader {
+    // network.json records the precision a network was saved in. loading converts the stored
+    // parameters to _Ty, so networks saved in either precision load in either
+    template <typename _Ty>
+    class basic_loader {
     public:
-        loader(const fs::path& directory);
-        ~loader() = default;
+        using network_type = basic_network<_Ty>;
 
-        loader(const loader&) = delete;
-        loader& operator=(const loader&) = delete;
+        basic_loader(const fs::path& directory);
+        ~basic_loader() = default;
+
+        basic_loader(const basic_loader&) = delete;
+        basic_loader& operator=(const basic_loader&) = delete;
 
         // will load and allocate a new network from file
         bool load_from_file();
 
-        // will save the loaded network to disk, if one exists
+        // will save the loaded network to disk in _Ty, if one exists
         bool save_to_file();
 
         // will take ownership of network. use with caution
-        bool load_from_memory(network* nn);
+        bool load_from_memory(network_type* nn);
 
         // checks if the loader has a network loaded
         bool has_network_loaded() const { return m_network.get() != nullptr; }
 
         // releases the currently loaded network from this loader. if no network is present, returns
         // nullptr
-        network* release_network() { return m_network.release(); }
+        network_type* release_network() { return m_network.release(); }
 
     private:
         fs::path m_directory, m_file;
-        std::unique_ptr<network> m_network;
+        std::unique_ptr<network_type> m_network;
     };
+
+    extern template class NN_API basic_loader<float>;
+    extern template class NN_API basic_loader<double>;
+
+    using loader = basic_loader<number_t>;
 } // namespace neuralnet
\ No newline at end of file
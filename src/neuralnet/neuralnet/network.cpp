@@ -3,32 +3,40 @@
 #include "neuralnet/util.h"
 
 namespace neuralnet {
-    number_t& network::get_bias_address(layer_t& layer, uint64_t current) {
+    template <typename _Ty>
+    _Ty& basic_network<_Ty>::get_bias_address(layer_type& layer, uint64_t current) {
         return layer.biases[current];
     }
 
-    number_t network::get_bias(const layer_t& layer, uint64_t current) {
+    template <typename _Ty>
+    _Ty basic_network<_Ty>::get_bias(const layer_type& layer, uint64_t current) {
         return layer.biases[current];
     }
 
-    number_t& network::get_weight_address(layer_t& layer, uint64_t current, uint64_t previous) {
+    template <typename _Ty>
+    _Ty& basic_network<_Ty>::get_weight_address(layer_type& layer, uint64_t current,
+                                                uint64_t previous) {
         // see neuralnet_layer_t::weights in network.h
         uint64_t index = current * layer.previous_size + previous;
         return layer.weights[index];
     }
 
-    number_t network::get_weight(const layer_t& layer, uint64_t current, uint64_t previous) {
+    template <typename _Ty>
+    _Ty basic_network<_Ty>::get_weight(const layer_type& layer, uint64_t current,
+                                       uint64_t previous) {
         uint64_t index = current * layer.previous_size + previous;
         return layer.weights[index];
     }
 
-    network* network::randomize(uint64_t input_size, const std::vector<layer_spec_t>& layers) {
+    template <typename _Ty>
+    basic_network<_Ty>* basic_network<_Ty>::randomize(uint64_t input_size,
+                                                      const std::vector<layer_spec_t>& layers) {
         ZoneScoped;
 
-        static constexpr number_t min = -1;
-        static constexpr number_t max = 1;
+        static constexpr _Ty min = -1;
+        static constexpr _Ty max = 1;
 
-        std::vector<layer_t> layer_data(layers.size());
+        std::vector<layer_type> layer_data(layers.size());
         for (size_t i = 0; i < layers.size(); i++) {
             const auto& spec = layers[i];
             auto& layer = layer_data[i];
@@ -49,10 +57,12 @@ namespace neuralnet {
             }
         }
 
-        return new network(layer_data);
+        return new basic_network(layer_data);
     }
 
-    network* network::randomize(const std::vector<uint64_t>& layer_sizes, activation_function function) {
+    template <typename _Ty>
+    basic_network<_Ty>* basic_network<_Ty>::randomize(const std::vector<uint64_t>& layer_sizes,
+                                                      activation_function function) {
         ZoneScoped;
 
         std::vector<layer_spec_t> layers;
@@ -65,7 +75,8 @@ namespace neuralnet {
         return randomize(layer_sizes[0], layers);
     }
 
-    void network::copy_layer(const layer_t& layer, layer_t& result) {
+    template <typename _Ty>
+    void basic_network<_Ty>::copy_layer(const layer_type& layer, layer_type& result) {
         ZoneScoped;
 
         result.size = layer.size;
@@ -75,30 +86,39 @@ namespace neuralnet {
         result.biases.resize(result.size);
         result.weights.resize(result.size * result.previous_size);
 
-        copy(layer.biases.data(), result.biases.data(), result.biases.size() * sizeof(number_t));
-        copy(layer.weights.data(), result.weights.data(), result.weights.size() * sizeof(number_t));
+        copy(layer.biases.data(), result.biases.data(), result.biases.size() * sizeof(_Ty));
+        copy(layer.weights.data(), result.weights.data(), result.weights.size() * sizeof(_Ty));
     }
 
-    network::network(const std::vector<layer_t>& layers) {
+    template <typename _Ty>
+    basic_network<_Ty>::basic_network(const std::vector<layer_type>& layers) {
         ZoneScoped;
 
         for (size_t i = 0; i < layers.size(); i++) {
-            const layer_t& src_layer = layers[i];
+            const layer_type& src_layer = layers[i];
+            if (src_layer.function == activation_function::softmax && i + 1 < layers.size()) {
+                throw std::runtime_error("softmax is only supported on the output layer!");
+            }
+
             if (i > 0) {
-                const layer_t& previous_layer = layers[i - 1];
+                const layer_type& previous_layer = layers[i - 1];
                 if (src_layer.previous_size != previous_layer.size) {
                     throw std::runtime_error("layer size mismatch!");
                 }
             }
 
-            layer_t& dst_layer = m_layers.emplace_back();
+            layer_type& dst_layer = m_layers.emplace_back();
             copy_layer(src_layer, dst_layer);
         }
     }
 
-    network::~network() {
+    template <typename _Ty>
+    basic_network<_Ty>::~basic_network() {
         ZoneScoped;
 
         // nothing
     }
+
+    template class NN_API basic_network<float>;
+    template class NN_API basic_network<double>;
 } // namespace neuralnet
\ No newline at end of file
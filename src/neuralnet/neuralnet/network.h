@@ -1,15 +1,78 @@
 #pragma once
 
 namespace neuralnet {
-    enum class activation_function { sigmoid };
+    // gelu is the tanh approximation, 0.5x(1 + tanh(sqrt(2 / pi)(x + 0.044715x^3)))
+    // softmax normalizes over the whole layer and is only allowed on the output layer, where it is
+    // trained against cross-entropy rather than squared error
+    // the values are shared with the shaders, see include/buffers.glsl
+    enum class activation_function { sigmoid, relu, leaky_relu, tanh, gelu, identity, softmax };
+
+    // slope of leaky_relu for negative inputs
+    inline constexpr number_t leaky_relu_slope = 0.01f;
+
+    // gelu(x) = x * sigmoid(gelu_scale * (x + gelu_cubic * x^3)), which is the same function
+    inline constexpr double gelu_scale = 1.5957691216057308; // 2 * sqrt(2 / pi)
+    inline constexpr double gelu_cubic = 0.044715;
+
+    // applies an activation function to a single value, for code that does not go through the
+    // evaluators' kernels. throws for softmax, see the overload below
+    template <typename _Ty>
+    inline _Ty activate(activation_function function, _Ty z) {
+        switch (function) {
+        case activation_function::sigmoid:
+            return 1 / (1 + std::exp(-z));
+        case activation_function::relu:
+            return std::max(z, (_Ty)0);
+        case activation_function::leaky_relu:
+            return z > 0 ? z : z * (_Ty)leaky_relu_slope;
+        case activation_function::tanh:
+            return std::tanh(z);
+        case activation_function::gelu:
+            return z / (1 + std::exp((_Ty)-gelu_scale * (z + (_Ty)gelu_cubic * z * z * z)));
+        case activation_function::identity:
+            return z;
+        default:
+            throw std::runtime_error("invalid activation function!");
+        }
+    }
+
+    // applies an activation function to a whole layer, in place
+    template <typename _Ty>
+    inline void activate(activation_function function, _Ty* values, size_t count) {
+        if (function != activation_function::softmax) {
+            for (size_t i = 0; i < count; i++) {
+                values[i] = activate(function, values[i]);
+            }
+
+            return;
+        }
+
+        // shifted by the largest value, so that nothing overflows
+        _Ty maximum = *std::max_element(values, values + count);
+        _Ty sum = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            values[i] = std::exp(values[i] - maximum);
+            sum += values[i];
+        }
+
+        for (size_t i = 0; i < count; i++) {
+            values[i] /= sum;
+        }
+    }
+
+    // _Ty is the precision parameters are stored and evaluated in. the library is instantiated for
+    // float and double, see network.cpp; number_t picks the default
+    template <typename _Ty>
+    struct basic_layer_t {
+        using value_type = _Ty;
 
-    struct layer_t {
         uint64_t size;
         uint64_t previous_size;
         activation_function function;
 
-        std::vector<number_t> biases;
-        std::vector<number_t> weights; // laid out row to row; rows represents neurons on the current layer
+        std::vector<_Ty> biases;
+        std::vector<_Ty> weights; // laid out row to row; rows represents neurons on the current layer
     };
 
     struct layer_spec_t {
@@ -17,27 +80,63 @@ namespace neuralnet {
         activation_function function;
     };
 
-    class NN_API network {
+    template <typename _Ty>
+    class basic_network {
     public:
-        static number_t& get_bias_address(layer_t& layer, uint64_t current);
-        static number_t get_bias(const layer_t& layer, uint64_t current);
-        static number_t& get_weight_address(layer_t& layer, uint64_t current, uint64_t previous);
-        static number_t get_weight(const layer_t& layer, uint64_t current, uint64_t previous);
+        using value_type = _Ty;
+        using layer_type = basic_layer_t<_Ty>;
+
+        static _Ty& get_bias_address(layer_type& layer, uint64_t current);
+        static _Ty get_bias(const layer_type& layer, uint64_t current);
+        static _Ty& get_weight_address(layer_type& layer, uint64_t current, uint64_t previous);
+        static _Ty get_weight(const layer_type& layer, uint64_t current, uint64_t previous);
 
-        static network* randomize(uint64_t input_size, const std::vector<layer_spec_t>& layers);
-        static network* randomize(const std::vector<uint64_t>& layer_sizes, activation_function function);
-        static void copy_layer(const layer_t& layer, layer_t& result);
+        static basic_network* randomize(uint64_t input_size,
+                                        const std::vector<layer_spec_t>& layers);
 
-        network(const std::vector<layer_t>& layers);
-        ~network();
+        static basic_network* randomize(const std::vector<uint64_t>& layer_sizes,
+                                        activation_function function);
 
-        network(const network&) = delete;
-        network& operator=(const network&) = delete;
+        static void copy_layer(const layer_type& layer, layer_type& result);
 
-        std::vector<layer_t>& get_layers() { return m_layers; }
-        const std::vector<layer_t>& get_layers() const { return m_layers; }
+        // copies a network of another precision, rounding every parameter to _Ty
+        template <typename _Other>
+        static basic_network* convert(const basic_network<_Other>* nn) {
+            ZoneScoped;
+
+            const auto& src_layers = nn->get_layers();
+            std::vector<layer_type> layers(src_layers.size());
+
+            for (size_t i = 0; i < layers.size(); i++) {
+                const auto& src = src_layers[i];
+                auto& dst = layers[i];
+
+                dst.size = src.size;
+                dst.previous_size = src.previous_size;
+                dst.function = src.function;
+                dst.biases.assign(src.biases.begin(), src.biases.end());
+                dst.weights.assign(src.weights.begin(), src.weights.end());
+            }
+
+            return new basic_network(layers);
+        }
+
+        basic_network(const std::vector<layer_type>& layers);
+        ~basic_network();
+
+        basic_network(const basic_network&) = delete;
+        basic_network& operator=(const basic_network&) = delete;
+
+        std::vector<layer_type>& get_layers() { return m_layers; }
+        const std::vector<layer_type>& get_layers() const { return m_layers; }
 
     private:
-        std::vector<layer_t> m_layers;
+        std::vector<layer_type> m_layers;
     };
+
+    extern template class NN_API basic_network<float>;
+    extern template class NN_API basic_network<double>;
+
+    using layer_t = basic_layer_t<number_t>;
+    using network = basic_network<number_t>;
 } // namespace neuralnet
\ No newline at end of file
@@ -0,0 +1,120 @@
+#include "nnpch.h"
+#include "neuralnet/precision.h"
+
+namespace neuralnet {
+    const char* get_parameter_format_name(parameter_format format) {
+        switch (format) {
+        case parameter_format::fp32:
+            return "fp32";
+        case parameter_format::fp16:
+            return "fp16";
+        case parameter_format::bf16:
+            return "bf16";
+        default:
+            return "unknown";
+        }
+    }
+
+    size_t get_parameter_format_size(parameter_format format) {
+        switch (format) {
+        case parameter_format::fp32:
+            return sizeof(float);
+        case parameter_format::fp16:
+        case parameter_format::bf16:
+            return sizeof(uint16_t);
+        default:
+            throw std::runtime_error("invalid parameter format!");
+        }
+    }
+
+    template <typename _Ty>
+    void reduce_parameters(const _Ty* src, uint16_t* dst, size_t count, parameter_format format) {
+        ZoneScoped;
+
+        switch (format) {
+        case parameter_format::fp16:
+            for (size_t i = 0; i < count; i++) {
+                dst[i] = to_half((float)src[i]);
+            }
+
+            break;
+        case parameter_format::bf16:
+            for (size_t i = 0; i < count; i++) {
+                dst[i] = to_bfloat16((float)src[i]);
+            }
+
+            break;
+        default:
+            throw std::runtime_error("not a 16-bit parameter format!");
+        }
+    }
+
+    template <typename _Ty>
+    void widen_parameters(const uint16_t* src, _Ty* dst, size_t count, parameter_format format) {
+        ZoneScoped;
+
+        switch (format) {
+        case parameter_format::fp16:
+            for (size_t i = 0; i < count; i++) {
+                dst[i] = from_half(src[i]);
+            }
+
+            break;
+        case parameter_format::bf16:
+            for (size_t i = 0; i < count; i++) {
+                dst[i] = from_bfloat16(src[i]);
+            }
+
+            break;
+        default:
+            throw std::runtime_error("not a 16-bit parameter format!");
+        }
+    }
+
+    template NN_API void reduce_parameters(const float*, uint16_t*, size_t, parameter_format);
+    template NN_API void reduce_parameters(const double*, uint16_t*, size_t, parameter_format);
+
+    template NN_API void widen_parameters(const uint16_t*, float*, size_t, parameter_format);
+    template NN_API void widen_parameters(const uint16_t*, double*, size_t, parameter_format);
+
+    reduced_network* reduced_network::reduce(const network* nn, parameter_format format) {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        std::vector<reduced_layer_t> reduced_layers(layers.size());
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            auto& reduced = reduced_layers[i];
+
+            reduced.size = layer.size;
+            reduced.previous_size = layer.previous_size;
+            reduced.function = layer.function;
+            reduced.biases = layer.biases;
+
+            reduced.weights.resize(layer.weights.size());
+            reduce_parameters(layer.weights.data(), reduced.weights.data(), layer.weights.size(),
+                              format);
+        }
+
+        return new reduced_network(format, reduced_layers);
+    }
+
+    reduced_network::reduced_network(parameter_format format,
+                                     const std::vector<reduced_layer_t>& layers) {
+        ZoneScoped;
+
+        m_format = format;
+        m_layers = layers;
+    }
+
+    size_t reduced_network::get_parameter_size() const {
+        size_t size = 0;
+        for (const auto& layer : m_layers) {
+            size += layer.weights.size() * sizeof(uint16_t);
+            size += layer.biases.size() * sizeof(number_t);
+        }
+
+        return size;
+    }
+} // namespace neuralnet
\ No newline at end of file
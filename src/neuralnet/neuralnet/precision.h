@@ -0,0 +1,123 @@
+#pragma once
+#include "neuralnet/network.h"
+
+namespace neuralnet {
+    // formats network parameters may be stored in by evaluators
+    // arithmetic is always carried out, and accumulated, in number_t
+    enum class parameter_format { fp32, fp16, bf16 };
+
+    NN_API const char* get_parameter_format_name(parameter_format format);
+
+    // bytes per stored parameter
+    NN_API size_t get_parameter_format_size(parameter_format format);
+
+    // ieee 754 binary16, rounded to nearest even. magnitudes past 65504 become infinity
+    inline uint16_t to_half(float value) {
+        uint32_t bits = std::bit_cast<uint32_t>(value);
+        uint32_t sign = (bits >> 16) & 0x8000;
+        uint32_t magnitude = bits & 0x7FFFFFFF;
+
+        // nan stays nan (quiet), anything that rounds past the largest half is infinity
+        if (magnitude > 0x7F800000) {
+            return (uint16_t)(sign | 0x7E00 | ((magnitude >> 13) & 0x3FF));
+        } else if (magnitude >= 0x477FF000) {
+            return (uint16_t)(sign | 0x7C00);
+        }
+
+        // subnormal halves: adding 0.5 lines the mantissa up with 2^-24 steps, and lets the fpu
+        // do the rounding
+        if (magnitude < 0x38800000) {
+            float shifted = std::bit_cast<float>(magnitude) + 0.5f;
+            return (uint16_t)(sign | (std::bit_cast<uint32_t>(shifted) - 0x3F000000));
+        }
+
+        // rebias the exponent (127 -> 15) and round the 13 dropped bits to nearest even
+        uint32_t odd = (magnitude >> 13) & 1;
+        magnitude += 0xC8000FFF + odd;
+
+        return (uint16_t)(sign | (magnitude >> 13));
+    }
+
+    inline float from_half(uint16_t value) {
+        // shifting into place and scaling by 2^(127 - 15) handles subnormals as well; infinities
+        // and nans only need their exponent widened
+        uint32_t magnitude = (uint32_t)(value & 0x7FFF) << 13;
+        float scaled = std::bit_cast<float>(magnitude) * std::bit_cast<float>(0x77800000u);
+
+        uint32_t bits = std::bit_cast<uint32_t>(scaled);
+        if ((value & 0x7C00) == 0x7C00) {
+            bits |= 0x7F800000;
+        }
+
+        return std::bit_cast<float>(bits | ((uint32_t)(value & 0x8000) << 16));
+    }
+
+    // the upper half of a binary32, rounded to nearest even
+    inline uint16_t to_bfloat16(float value) {
+        uint32_t bits = std::bit_cast<uint32_t>(value);
+        if ((bits & 0x7FFFFFFF) > 0x7F800000) {
+            return (uint16_t)((bits >> 16) | 0x40);
+        }
+
+        bits += 0x7FFF + ((bits >> 16) & 1);
+        return (uint16_t)(bits >> 16);
+    }
+
+    inline float from_bfloat16(uint16_t value) {
+        return std::bit_cast<float>((uint32_t)value << 16);
+    }
+
+    // converts parameters to and from a 16-bit format. throws for fp32
+    // instantiated for float and double; doubles are rounded through float on the way down
+    template <typename _Ty>
+    void reduce_parameters(const _Ty* src, uint16_t* dst, size_t count, parameter_format format);
+
+    template <typename _Ty>
+    void widen_parameters(const uint16_t* src, _Ty* dst, size_t count, parameter_format format);
+
+    extern template NN_API void reduce_parameters(const float*, uint16_t*, size_t,
+                                                  parameter_format);
+    extern template NN_API void reduce_parameters(const double*, uint16_t*, size_t,
+                                                  parameter_format);
+
+    extern template NN_API void widen_parameters(const uint16_t*, float*, size_t,
+                                                 parameter_format);
+    extern template NN_API void widen_parameters(const uint16_t*, double*, size_t,
+                                                 parameter_format);
+
+    // 16-bit copy of a layer, for inference only. biases stay in full precision
+    struct reduced_layer_t {
+        uint64_t size;
+        uint64_t previous_size;
+        activation_function function;
+
+        // laid out like layer_t::weights, in the network's format
+        std::vector<uint16_t> weights;
+        std::vector<number_t> biases;
+    };
+
+    // weights of a network in a 16-bit format, and nothing else. unlike the copy evaluators keep
+    // next to the full precision weights, this replaces them: once the source network is freed,
+    // its weights take half the memory
+    class NN_API reduced_network {
+    public:
+        // rounds every weight of a network to a 16-bit format. throws for fp32
+        static reduced_network* reduce(const network* nn, parameter_format format);
+
+        reduced_network(parameter_format format, const std::vector<reduced_layer_t>& layers);
+        ~reduced_network() = default;
+
+        reduced_network(const reduced_network&) = delete;
+        reduced_network& operator=(const reduced_network&) = delete;
+
+        parameter_format get_format() const { return m_format; }
+        const std::vector<reduced_layer_t>& get_layers() const { return m_layers; }
+
+        // bytes held by weights and biases
+        size_t get_parameter_size() const;
+
+    private:
+        parameter_format m_format;
+        std::vector<reduced_layer_t> m_layers;
+    };
+} // namespace neuralnet
\ No newline at end of file
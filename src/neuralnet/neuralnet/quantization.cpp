@@ -0,0 +1,114 @@
+#include "nnpch.h"
+#include "neuralnet/quantization.h"
+
+namespace neuralnet {
+    // scale mapping the largest magnitude onto 127. empty ranges fall back to [-1, 1]
+    static number_t get_scale(number_t max_magnitude) {
+        return max_magnitude > 0 ? max_magnitude / 127 : (number_t)1 / 127;
+    }
+
+    quantized_network* quantized_network::quantize(const network* nn, const dataset* data,
+                                                   dataset_group group,
+                                                   uint64_t calibration_samples) {
+        ZoneScoped;
+
+        const auto& layers = nn->get_layers();
+        std::vector<number_t> input_ranges(layers.size(), 0);
+        std::vector<bool> negative_inputs(layers.size(), false);
+
+        uint64_t sample_count = std::min(calibration_samples, data->get_sample_count(group));
+        std::vector<number_t> inputs, outputs, activations;
+
+        for (uint64_t sample = 0; sample < sample_count; sample++) {
+            if (!data->get_sample(group, sample, inputs, outputs)) {
+                continue;
+            }
+
+            if (inputs.size() != layers[0].previous_size) {
+                throw std::runtime_error("input count mismatch!");
+            }
+
+            for (size_t i = 0; i < layers.size(); i++) {
+                const auto& layer = layers[i];
+                for (number_t x : inputs) {
+                    input_ranges[i] = std::max(input_ranges[i], std::abs(x));
+                    if (x < 0) {
+                        negative_inputs[i] = true;
+                    }
+                }
+
+                activations.resize(layer.size);
+                for (uint64_t c = 0; c < layer.size; c++) {
+                    number_t z = layer.biases[c];
+                    for (uint64_t p = 0; p < layer.previous_size; p++) {
+                        z += network::get_weight(layer, c, p) * inputs[p];
+                    }
+
+                    activations[c] = z;
+                }
+
+                activate(layer.function, activations.data(), activations.size());
+
+                inputs.swap(activations);
+            }
+        }
+
+        std::vector<quantized_layer_t> quantized_layers(layers.size());
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            auto& quantized = quantized_layers[i];
+
+            quantized.size = layer.size;
+            quantized.previous_size = layer.previous_size;
+            quantized.function = layer.function;
+            quantized.input_scale = get_scale(input_ranges[i]);
+            quantized.unsigned_inputs = sample_count > 0 && !negative_inputs[i];
+            quantized.biases = layer.biases;
+
+            quantized.weights.resize(layer.weights.size());
+            quantized.weight_scales.resize(layer.size);
+
+            for (uint64_t c = 0; c < layer.size; c++) {
+                const number_t* row = &layer.weights[c * layer.previous_size];
+
+                number_t range = 0;
+                for (uint64_t p = 0; p < layer.previous_size; p++) {
+                    range = std::max(range, std::abs(row[p]));
+                }
+
+                number_t scale = get_scale(range);
+                quantized.weight_scales[c] = scale;
+
+                quantize_values(row, &quantized.weights[c * layer.previous_size],
+                                layer.previous_size, scale);
+            }
+        }
+
+        return new quantized_network(quantized_layers);
+    }
+
+    quantized_network::quantized_network(const std::vector<quantized_layer_t>& layers) {
+        ZoneScoped;
+        m_layers = layers;
+    }
+
+    size_t quantized_network::get_parameter_size() const {
+        size_t size = 0;
+        for (const auto& layer : m_layers) {
+            size += layer.weights.size() * sizeof(int8_t);
+            size += (layer.weight_scales.size() + layer.biases.size() + 1) * sizeof(number_t);
+        }
+
+        return size;
+    }
+
+    void quantize_values(const number_t* x, int8_t* q, size_t count, number_t scale) {
+        ZoneScoped;
+
+        number_t inverse_scale = 1 / scale;
+        for (size_t i = 0; i < count; i++) {
+            number_t value = std::clamp(x[i] * inverse_scale, (number_t)-127, (number_t)127);
+            q[i] = (int8_t)std::nearbyint(value);
+        }
+    }
+} // namespace neuralnet
\ No newline at end of file
@@ -0,0 +1,53 @@
+#pragma once
+#include "neuralnet/network.h"
+#include "neuralnet/trainer.h"
+
+namespace neuralnet {
+    // int8 copy of a layer, for inference only
+    // weights are quantized symmetrically per row (neuron), inputs per layer, both to [-127, 127]
+    struct quantized_layer_t {
+        uint64_t size;
+        uint64_t previous_size;
+        activation_function function;
+
+        // an input x is stored as round(x / input_scale)
+        number_t input_scale;
+
+        // set if calibration saw no negative inputs. inputs are then clamped at zero, which lets
+        // them be multiplied as unsigned bytes
+        bool unsigned_inputs;
+
+        // laid out like layer_t::weights. a weight is weights[i] * weight_scales[row]
+        std::vector<int8_t> weights;
+        std::vector<number_t> weight_scales;
+
+        // added after the integer dot product, in full precision
+        std::vector<number_t> biases;
+    };
+
+    class NN_API quantized_network {
+    public:
+        // quantizes every layer of a network. each layer's input scale is calibrated on the
+        // largest magnitude that layer sees over up to calibration_samples samples of the given
+        // group, evaluated in full precision
+        static quantized_network* quantize(const network* nn, const dataset* data,
+                                           dataset_group group, uint64_t calibration_samples);
+
+        quantized_network(const std::vector<quantized_layer_t>& layers);
+        ~quantized_network() = default;
+
+        quantized_network(const quantized_network&) = delete;
+        quantized_network& operator=(const quantized_network&) = delete;
+
+        const std::vector<quantized_layer_t>& get_layers() const { return m_layers; }
+
+        // bytes held by weights, scales and biases
+        size_t get_parameter_size() const;
+
+    private:
+        std::vector<quantized_layer_t> m_layers;
+    };
+
+    // q[i] = round(x[i] / scale), clamped to [-127, 127]
+    NN_API void quantize_values(const number_t* x, int8_t* q, size_t count, number_t scale);
+} // namespace neuralnet
\ No newline at end of file
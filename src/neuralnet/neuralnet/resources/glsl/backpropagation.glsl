@@ -9,6 +9,18 @@ float dA_dx(float x, uint id) {
     switch (id) {
     case SIGMOID:
         return dsigmoid_dx(x);
+    case RELU:
+        return drelu_dx(x);
+    case LEAKY_RELU:
+        return dleaky_relu_dx(x);
+    case TANH:
+        return dtanh_dx(x);
+    case GELU:
+        return dgelu_dx(x);
+    case IDENTITY:
+        return 1;
+    case SOFTMAX:
+        return 1; // fused into the cost, see main
     default:
         return 0;
     }
@@ -31,7 +43,13 @@ void main() {
             float a = imageLoad(activations, ivec3(int(c), int(layer) + 1, int(pass))).x;
             float y = imageLoad(activations, ivec3(int(c), int(layer) + 2, int(pass))).x;
 
-            dC_da = dC_dx(a, y);
+            // softmax outputs are trained against cross-entropy. differentiated together, the two
+            // give dC/dz = a - y, which dA_dx passes through untouched
+            if (layer_info.activation_function == SOFTMAX) {
+                dC_da = a - y;
+            } else {
+                dC_da = dC_dx(a, y);
+            }
         } else {
             dC_da = 0;
 
@@ -39,7 +57,7 @@ void main() {
             layer_t next_layer_info = network.layers[next_layer];
             
             for (uint n = 0; n < next_layer_info.size; n++) {
-                float weight = imageLoad(layer_data, ivec3(int(n), int(c) + 1, int(next_layer))).x;
+                float weight = load_parameter(ivec3(int(n), int(c) + 1, int(next_layer)));
                 float dC_db_n = imageLoad(deltas, ivec3(int(n), 0, int(next_layer + delta_z_offset))).x;
                 float dC_dz_n = dC_db_n / 1; // dz/db
 
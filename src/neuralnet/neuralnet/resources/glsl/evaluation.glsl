@@ -11,6 +11,18 @@ float A(float x, uint id) {
     switch (id) {
     case SIGMOID:
         return sigmoid(x);
+    case RELU:
+        return relu(x);
+    case LEAKY_RELU:
+        return leaky_relu(x);
+    case TANH:
+        return tanh_clamped(x);
+    case GELU:
+        return gelu(x);
+    case IDENTITY:
+        return x;
+    case SOFTMAX:
+        return x; // normalized over the layer afterwards, see softmax.glsl
     default:
         return 0;
     }
@@ -50,7 +62,7 @@ void main() {
         // z is initially set to the bias (constant term)
         // bias comes before weights in each data image row
         // each texel only has one value, hence we take the x component
-        float z = imageLoad(layer_data, ivec3(0, int(c), int(layer))).x;
+        float z = load_parameter(ivec3(0, int(c), int(layer)));
 
         // matrix multiplication
         // nxm matrix * mxl matrix = nxl matrix
@@ -58,7 +70,7 @@ void main() {
         // we know c, so we iterate over p
         for (uint p = 0; p < layer_info.previous_size; p++) {
             // see previous explanation on data image
-            float weight = imageLoad(layer_data, ivec3(int(p) + 1, int(c), int(layer))).x;
+            float weight = load_parameter(ivec3(int(p) + 1, int(c), int(layer)));
 
             // each row of the activation image corresponds to the layer
             // each column corresponds to a neuron index
@@ -1,6 +1,18 @@
 #define MAX_LAYERS 32
 
+// see activation_function
 #define SIGMOID 0
+#define RELU 1
+#define LEAKY_RELU 2
+#define TANH 3
+#define GELU 4
+#define IDENTITY 5
+#define SOFTMAX 6
+
+// see leaky_relu_slope, gelu_scale and gelu_cubic
+#define LEAKY_RELU_SLOPE 0.01
+#define GELU_SCALE 1.5957691216057308
+#define GELU_CUBIC 0.044715
 
 // activation value matrix
 layout(set = 0, binding = 0, r32f) uniform image3D activations;
@@ -21,10 +33,48 @@ layout(set = 1, binding = 0, std430) buffer network_t {
     layer_t layers[MAX_LAYERS];
 } network;
 
+// storage format of layer_data (see parameter_format)
+// each shader is compiled once per format, see CMakeLists.txt
+#define PARAMETER_FORMAT_FP32 0
+#define PARAMETER_FORMAT_FP16 1
+#define PARAMETER_FORMAT_BF16 2
+
+#ifndef PARAMETER_FORMAT
+#define PARAMETER_FORMAT PARAMETER_FORMAT_FP32
+#endif
+
 // rows correspond to a neuron on the current layer
 // laid out such that biases come before weights in rows
 // each z-layer corresponds to a network layer
+#if PARAMETER_FORMAT == PARAMETER_FORMAT_BF16
+// no bfloat16 image format exists, so these are the upper 16 bits of each float
+layout(set = 1, binding = 1, r16ui) uniform uimage3D layer_data;
+#elif PARAMETER_FORMAT == PARAMETER_FORMAT_FP16
+layout(set = 1, binding = 1, r16f) uniform image3D layer_data;
+#else
 layout(set = 1, binding = 1, r32f) uniform image3D layer_data;
+#endif
+
+// all reads & writes of layer_data go through these, so that math stays in fp32
+float load_parameter(ivec3 coords) {
+#if PARAMETER_FORMAT == PARAMETER_FORMAT_BF16
+    return uintBitsToFloat(imageLoad(layer_data, coords).x << 16);
+#else
+    return imageLoad(layer_data, coords).x;
+#endif
+}
+
+void store_parameter(ivec3 coords, float value) {
+#if PARAMETER_FORMAT == PARAMETER_FORMAT_BF16
+    // round to nearest even, see to_bfloat16
+    uint bits = floatBitsToUint(value);
+    bits += 0x7FFF + ((bits >> 16) & 1);
+
+    imageStore(layer_data, coords, uvec4(bits >> 16, 0, 0, 0));
+#else
+    imageStore(layer_data, coords, vec4(value, 0, 0, 0));
+#endif
+}
 
 // specified per dispatch
 layout(push_constant) uniform push_constants_t {
@@ -10,6 +10,44 @@ float dsigmoid_dx(float x) {
     return sig * (1 - sig);
 }
 
+float relu(float x) {
+    return max(x, 0.0);
+}
+
+float drelu_dx(float x) {
+    return x > 0 ? 1.0 : 0.0;
+}
+
+float leaky_relu(float x) {
+    return x > 0 ? x : x * LEAKY_RELU_SLOPE;
+}
+
+float dleaky_relu_dx(float x) {
+    return x > 0 ? 1.0 : LEAKY_RELU_SLOPE;
+}
+
+// the builtin may overflow to inf / inf for large x, and tanh(10) is already 1 in fp32
+float tanh_clamped(float x) {
+    return tanh(clamp(x, -10.0, 10.0));
+}
+
+float dtanh_dx(float x) {
+    float t = tanh_clamped(x);
+    return 1 - t * t;
+}
+
+// see simd_gelu_gradient
+float gelu(float x) {
+    return x * sigmoid(GELU_SCALE * (x + GELU_CUBIC * x * x * x));
+}
+
+float dgelu_dx(float x) {
+    float sig = sigmoid(GELU_SCALE * (x + GELU_CUBIC * x * x * x));
+    float du_dx = GELU_SCALE * (1 + 3 * GELU_CUBIC * x * x);
+
+    return sig + x * sig * (1 - sig) * du_dx;
+}
+
 float dC_dx(float x, float y) {
     //   d/dx((x - y)^2)
     // = d/dx(x - y) * d((x - y)^2)/d(x - y)
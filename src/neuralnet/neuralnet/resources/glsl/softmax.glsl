@@ -0,0 +1,77 @@
+#version 460
+// second half of evaluating a softmax layer, see evaluation.glsl
+// every neuron is normalized against the z values of its whole layer, which evaluation.glsl has
+// already stored. each work group normalizes one pass: its invocations reduce the largest z and
+// the sum of exponents together, once, and then store a share of the activations each
+
+#include "include/buffers.glsl"
+
+#define GROUP_SIZE 64
+
+layout(local_size_x = GROUP_SIZE, local_size_y = 1, local_size_z = 1) in;
+
+shared float partials[GROUP_SIZE];
+
+// combines the values of every invocation in the work group, with max or with addition
+// must be reached by the whole work group
+float reduce(float value, bool maximum) {
+    uint index = gl_LocalInvocationID.x;
+    partials[index] = value;
+
+    for (uint stride = GROUP_SIZE / 2; stride > 0; stride /= 2) {
+        memoryBarrierShared();
+        barrier();
+
+        if (index < stride) {
+            float other = partials[index + stride];
+            partials[index] = maximum ? max(partials[index], other) : partials[index] + other;
+        }
+    }
+
+    memoryBarrierShared();
+    barrier();
+
+    float result = partials[0];
+
+    // the next reduction overwrites partials
+    barrier();
+    return result;
+}
+
+float load_z(uint n, uint layer, uint pass) {
+    return imageLoad(z_values, ivec3(int(n), int(layer), int(pass))).x;
+}
+
+void main() {
+    uint layer = push_constants.layer;
+    uint index = gl_LocalInvocationID.x;
+    uint pass = gl_WorkGroupID.y;
+
+    layer_t layer_info = network.layers[layer];
+    uint pass_count = imageSize(activations).z;
+
+    // the same for the whole work group, so that either all of it reaches the barriers or none
+    if (pass >= pass_count) {
+        return;
+    }
+
+    // shifted by the largest z, so that nothing overflows
+    float maximum = uintBitsToFloat(0xFF800000u); // -inf
+    for (uint n = index; n < layer_info.size; n += GROUP_SIZE) {
+        maximum = max(maximum, load_z(n, layer, pass));
+    }
+
+    maximum = reduce(maximum, true);
+
+    float sum = 0;
+    for (uint n = index; n < layer_info.size; n += GROUP_SIZE) {
+        sum += exp(load_z(n, layer, pass) - maximum);
+    }
+
+    sum = reduce(sum, false);
+
+    for (uint n = index; n < layer_info.size; n += GROUP_SIZE) {
+        float a = exp(load_z(n, layer, pass) - maximum) / sum;
+        imageStore(activations, ivec3(int(n), int(layer) + 1, int(pass)), vec4(a, 0, 0, 0));
+    }
+}
\ No newline at end of file
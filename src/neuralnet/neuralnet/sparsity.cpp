@@ -0,0 +1,153 @@
+#include "nnpch.h"
+#include "neuralnet/sparsity.h"
+
+namespace neuralnet {
+    template <typename _Ty>
+    double get_weight_density(const basic_layer_t<_Ty>& layer) {
+        ZoneScoped;
+
+        if (layer.weights.empty()) {
+            return 0;
+        }
+
+        size_t non_zero = 0;
+        for (_Ty weight : layer.weights) {
+            non_zero += weight != 0 ? 1 : 0;
+        }
+
+        return (double)non_zero / (double)layer.weights.size();
+    }
+
+    template <typename _Ty>
+    uint64_t prune_weights(basic_network<_Ty>* nn, _Ty threshold) {
+        ZoneScoped;
+
+        uint64_t pruned = 0;
+        for (auto& layer : nn->get_layers()) {
+            for (_Ty& weight : layer.weights) {
+                if (std::abs(weight) < threshold) {
+                    weight = 0;
+                    pruned++;
+                }
+            }
+        }
+
+        return pruned;
+    }
+
+    template <typename _Ty>
+    uint64_t prune_weights_to_sparsity(basic_network<_Ty>* nn, double sparsity) {
+        ZoneScoped;
+
+        if (sparsity < 0 || sparsity > 1) {
+            throw std::runtime_error("sparsity must lie within [0, 1]!");
+        }
+
+        uint64_t pruned = 0;
+        std::vector<_Ty> magnitudes;
+
+        for (auto& layer : nn->get_layers()) {
+            auto count = (size_t)std::ceil(sparsity * (double)layer.weights.size());
+            if (count == 0) {
+                continue;
+            }
+
+            // the count-th smallest magnitude. everything below it goes, and ties with it are
+            // broken in storage order
+            magnitudes.resize(layer.weights.size());
+            for (size_t i = 0; i < magnitudes.size(); i++) {
+                magnitudes[i] = std::abs(layer.weights[i]);
+            }
+
+            std::nth_element(magnitudes.begin(), magnitudes.begin() + (count - 1),
+                             magnitudes.end());
+
+            _Ty cutoff = magnitudes[count - 1];
+            size_t below = 0;
+
+            for (_Ty weight : layer.weights) {
+                below += std::abs(weight) < cutoff ? 1 : 0;
+            }
+
+            size_t ties = count - below;
+            for (_Ty& weight : layer.weights) {
+                _Ty magnitude = std::abs(weight);
+                if (magnitude < cutoff || (magnitude == cutoff && ties > 0)) {
+                    ties -= magnitude == cutoff ? 1 : 0;
+                    weight = 0;
+                }
+            }
+
+            pruned += count;
+        }
+
+        return pruned;
+    }
+
+    template <typename _Ty>
+    void compress_weights(const basic_layer_t<_Ty>& layer, basic_sparse_weights_t<_Ty>& sparse) {
+        ZoneScoped;
+
+        if (layer.previous_size > std::numeric_limits<uint32_t>::max() ||
+            layer.weights.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::runtime_error("layer too large to compress!");
+        }
+
+        sparse.rows = layer.size;
+        sparse.columns = layer.previous_size;
+
+        sparse.offsets.resize(layer.size + 1);
+        sparse.indices.clear();
+        sparse.values.clear();
+
+        for (uint64_t c = 0; c < layer.size; c++) {
+            sparse.offsets[c] = (uint32_t)sparse.values.size();
+
+            const _Ty* row = &layer.weights[c * layer.previous_size];
+            for (uint64_t p = 0; p < layer.previous_size; p++) {
+                if (row[p] != 0) {
+                    sparse.indices.push_back((uint32_t)p);
+                    sparse.values.push_back(row[p]);
+                }
+            }
+        }
+
+        sparse.offsets[layer.size] = (uint32_t)sparse.values.size();
+    }
+
+    template <typename _Ty>
+    void expand_weights(const basic_sparse_weights_t<_Ty>& sparse, basic_layer_t<_Ty>& layer) {
+        ZoneScoped;
+
+        if (sparse.rows != layer.size || sparse.columns != layer.previous_size) {
+            throw std::runtime_error("layer shape mismatch!");
+        }
+
+        layer.weights.assign(layer.size * layer.previous_size, 0);
+        for (uint64_t c = 0; c < sparse.rows; c++) {
+            _Ty* row = &layer.weights[c * layer.previous_size];
+            for (uint32_t i = sparse.offsets[c]; i < sparse.offsets[c + 1]; i++) {
+                row[sparse.indices[i]] = sparse.values[i];
+            }
+        }
+    }
+
+    template NN_API double get_weight_density(const basic_layer_t<float>&);
+    template NN_API double get_weight_density(const basic_layer_t<double>&);
+
+    template NN_API uint64_t prune_weights(basic_network<float>*, float);
+    template NN_API uint64_t prune_weights(basic_network<double>*, double);
+
+    template NN_API uint64_t prune_weights_to_sparsity(basic_network<float>*, double);
+    template NN_API uint64_t prune_weights_to_sparsity(basic_network<double>*, double);
+
+    template NN_API void compress_weights(const basic_layer_t<float>&,
+                                          basic_sparse_weights_t<float>&);
+    template NN_API void compress_weights(const basic_layer_t<double>&,
+                                          basic_sparse_weights_t<double>&);
+
+    template NN_API void expand_weights(const basic_sparse_weights_t<float>&,
+                                        basic_layer_t<float>&);
+    template NN_API void expand_weights(const basic_sparse_weights_t<double>&,
+                                        basic_layer_t<double>&);
+} // namespace neuralnet
\ No newline at end of file
@@ -0,0 +1,58 @@
+#pragma once
+#include "neuralnet/network.h"
+
+namespace neuralnet {
+    // compressed sparse row copy of a layer's weights (size x previous_size), holding only the
+    // non-zero ones. row c owns entries [offsets[c], offsets[c + 1]) of columns and values, in
+    // ascending column order
+    template <typename _Ty>
+    struct basic_sparse_weights_t {
+        uint64_t rows, columns;
+
+        std::vector<uint32_t> offsets, indices;
+        std::vector<_Ty> values;
+    };
+
+    using sparse_weights_t = basic_sparse_weights_t<number_t>;
+
+    // fraction of a layer's weights that are not zero
+    template <typename _Ty>
+    double get_weight_density(const basic_layer_t<_Ty>& layer);
+
+    // zeroes every weight with a magnitude below threshold. biases are left alone. training does
+    // not keep pruned weights at zero; prune again once it is done
+    // returns the number of weights zeroed, including ones that were zero already
+    template <typename _Ty>
+    uint64_t prune_weights(basic_network<_Ty>* nn, _Ty threshold);
+
+    // zeroes the smallest weights of every layer, until at least the given fraction (0-1) of each
+    // layer's weights is zero. returns the number of weights zeroed, as above
+    template <typename _Ty>
+    uint64_t prune_weights_to_sparsity(basic_network<_Ty>* nn, double sparsity);
+
+    template <typename _Ty>
+    void compress_weights(const basic_layer_t<_Ty>& layer, basic_sparse_weights_t<_Ty>& sparse);
+
+    // overwrites the layer's weights with the expanded matrix. the shapes must match
+    template <typename _Ty>
+    void expand_weights(const basic_sparse_weights_t<_Ty>& sparse, basic_layer_t<_Ty>& layer);
+
+    extern template NN_API double get_weight_density(const basic_layer_t<float>&);
+    extern template NN_API double get_weight_density(const basic_layer_t<double>&);
+
+    extern template NN_API uint64_t prune_weights(basic_network<float>*, float);
+    extern template NN_API uint64_t prune_weights(basic_network<double>*, double);
+
+    extern template NN_API uint64_t prune_weights_to_sparsity(basic_network<float>*, double);
+    extern template NN_API uint64_t prune_weights_to_sparsity(basic_network<double>*, double);
+
+    extern template NN_API void compress_weights(const basic_layer_t<float>&,
+                                                 basic_sparse_weights_t<float>&);
+    extern template NN_API void compress_weights(const basic_layer_t<double>&,
+                                                 basic_sparse_weights_t<double>&);
+
+    extern template NN_API void expand_weights(const basic_sparse_weights_t<float>&,
+                                               basic_layer_t<float>&);
+    extern template NN_API void expand_weights(const basic_sparse_weights_t<double>&,
+                                               basic_layer_t<double>&);
+} // namespace neuralnet
\ No newline at end of file
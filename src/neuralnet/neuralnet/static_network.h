@@ -0,0 +1,179 @@
+#pragma once
+#include "neuralnet/network.h"
+#include "neuralnet/evaluators/cpu_kernels.h"
+
+namespace neuralnet {
+    template <typename _Ty, uint64_t _Inputs, uint64_t _Outputs>
+    struct static_layer_t {
+        // transposed relative to layer_t (previous_size x size), so that every input adds one
+        // contiguous row to the layer's outputs
+        alignas(64) std::array<_Ty, _Inputs * _Outputs> weights;
+        alignas(64) std::array<_Ty, _Outputs> biases;
+    };
+
+    // inference-only copy of a network whose shape and activation functions are fixed at compile
+    // time. every loop has a constant trip count, so the compiler can unroll and vectorize it, and
+    // evaluation neither allocates nor branches on the layer. _Hidden is the activation function
+    // of every layer but the last, which uses _Output. _Sizes lists the input count, then the size
+    // of every layer
+    // parameters are stored inline (about 400 KiB for 784-128-64-32-10), so instances belong in
+    // static or heap storage rather than on the stack
+    template <typename _Ty, activation_function _Hidden, activation_function _Output,
+              uint64_t... _Sizes>
+    class basic_static_network {
+    public:
+        static_assert(sizeof...(_Sizes) > 1, "a network needs inputs and at least one layer!");
+        static_assert(_Hidden != activation_function::softmax || sizeof...(_Sizes) == 2,
+                      "softmax is only supported on the output layer!");
+
+        static constexpr std::array<uint64_t, sizeof...(_Sizes)> sizes = { _Sizes... };
+        static constexpr size_t layer_count = sizes.size() - 1;
+        static constexpr uint64_t input_count = sizes[0];
+        static constexpr uint64_t output_count = sizes[layer_count];
+
+        basic_static_network() { m_kernels = &evaluators::get_cpu_kernels<_Ty>(); }
+
+        // copies the parameters of a network with the same shape and activation functions.
+        // returns false if they differ
+        bool load(const basic_network<_Ty>* nn) {
+            ZoneScoped;
+
+            const auto& layers = nn->get_layers();
+            if (layers.size() != layer_count) {
+                return false;
+            }
+
+            for (size_t i = 0; i < layer_count; i++) {
+                const auto& layer = layers[i];
+                if (layer.previous_size != sizes[i] || layer.size != sizes[i + 1] ||
+                    layer.function != get_function(i)) {
+                    return false;
+                }
+            }
+
+            load_layers(layers, std::make_index_sequence<layer_count>());
+            return true;
+        }
+
+        // evaluates a single sample on the calling thread
+        void eval(std::span<const _Ty, input_count> inputs,
+                  std::span<_Ty, output_count> outputs) const {
+            ZoneScoped;
+
+            std::array<_Ty, scratch_size> scratch[2];
+            eval_layers(inputs.data(), outputs.data(), scratch,
+                        std::make_index_sequence<layer_count>());
+        }
+
+    private:
+        static constexpr activation_function get_function(size_t layer) {
+            return layer + 1 < layer_count ? _Hidden : _Output;
+        }
+
+        // hidden layers ping-pong between two buffers of the widest hidden layer
+        static constexpr uint64_t scratch_size = []() {
+            uint64_t width = 1;
+            for (size_t i = 1; i < layer_count; i++) {
+                width = std::max(width, sizes[i]);
+            }
+
+            return width;
+        }();
+
+        template <size_t... _Indices>
+        static auto make_layers(std::index_sequence<_Indices...>)
+            -> std::tuple<static_layer_t<_Ty, sizes[_Indices], sizes[_Indices + 1]>...>;
+
+        using layers_type = decltype(make_layers(std::make_index_sequence<layer_count>()));
+
+        template <size_t... _Indices>
+        void load_layers(const std::vector<basic_layer_t<_Ty>>& layers,
+                         std::index_sequence<_Indices...>) {
+            (load_layer<_Indices>(layers[_Indices]), ...);
+        }
+
+        template <size_t _Index>
+        void load_layer(const basic_layer_t<_Ty>& src) {
+            constexpr uint64_t previous_size = sizes[_Index];
+            constexpr uint64_t size = sizes[_Index + 1];
+
+            auto& dst = std::get<_Index>(m_layers);
+            std::copy(src.biases.begin(), src.biases.end(), dst.biases.begin());
+
+            for (uint64_t c = 0; c < size; c++) {
+                for (uint64_t p = 0; p < previous_size; p++) {
+                    dst.weights[p * size + c] = src.weights[c * previous_size + p];
+                }
+            }
+        }
+
+        template <size_t... _Indices>
+        void eval_layers(const _Ty* inputs, _Ty* outputs, std::array<_Ty, scratch_size>* scratch,
+                         std::index_sequence<_Indices...>) const {
+            const _Ty* previous_activations = inputs;
+            ((previous_activations = eval_layer<_Indices>(
+                  previous_activations,
+                  _Indices + 1 < layer_count ? scratch[_Indices % 2].data() : outputs)),
+             ...);
+        }
+
+        template <size_t _Index>
+        const _Ty* eval_layer(const _Ty* inputs, _Ty* activations) const {
+            constexpr uint64_t previous_size = sizes[_Index];
+            constexpr uint64_t size = sizes[_Index + 1];
+            constexpr activation_function function = get_function(_Index);
+            const auto& layer = std::get<_Index>(m_layers);
+
+            // accumulated in a local, which the compiler knows aliases nothing. inputs are taken
+            // four at a time, so that every output is loaded and stored once per four rows
+            constexpr uint64_t group = 4;
+            constexpr uint64_t grouped_size = previous_size - previous_size % group;
+
+            std::array<_Ty, size> z = layer.biases;
+            for (uint64_t p = 0; p < grouped_size; p += group) {
+                const _Ty* rows = &layer.weights[p * size];
+
+                for (uint64_t c = 0; c < size; c++) {
+                    z[c] += inputs[p] * rows[c] + inputs[p + 1] * rows[size + c] +
+                            inputs[p + 2] * rows[size * 2 + c] + inputs[p + 3] * rows[size * 3 + c];
+                }
+            }
+
+            for (uint64_t p = grouped_size; p < previous_size; p++) {
+                const _Ty* row = &layer.weights[p * size];
+                for (uint64_t c = 0; c < size; c++) {
+                    z[c] += inputs[p] * row[c];
+                }
+            }
+
+            if constexpr (function == activation_function::sigmoid) {
+                m_kernels->sigmoid(z.data(), activations, size);
+            } else if constexpr (function == activation_function::relu) {
+                m_kernels->relu(z.data(), activations, size);
+            } else if constexpr (function == activation_function::leaky_relu) {
+                m_kernels->leaky_relu(z.data(), activations, size, (_Ty)leaky_relu_slope);
+            } else if constexpr (function == activation_function::tanh) {
+                m_kernels->tanh(z.data(), activations, size);
+            } else if constexpr (function == activation_function::gelu) {
+                m_kernels->gelu(z.data(), activations, size);
+            } else if constexpr (function == activation_function::identity) {
+                std::copy(z.begin(), z.end(), activations);
+            } else if constexpr (function == activation_function::softmax) {
+                m_kernels->softmax(z.data(), activations, size);
+            } else {
+                static_assert(function == activation_function::sigmoid,
+                              "unsupported activation function!");
+            }
+
+            return activations;
+        }
+
+        layers_type m_layers;
+        const evaluators::basic_cpu_kernels_t<_Ty>* m_kernels;
+    };
+
+    // sigmoid hidden layers and a softmax output, as the mnist network defaults to
+    template <uint64_t... _Sizes>
+    using static_network = basic_static_network<number_t, activation_function::sigmoid,
+                                                activation_function::softmax, _Sizes...>;
+} // namespace neuralnet
\ No newline at end of file
@@ -0,0 +1,133 @@
+#include "nnpch.h"
+#include "neuralnet/thread_pool.h"
+
+namespace neuralnet {
+    thread_pool::thread_pool(size_t thread_count) {
+        ZoneScoped;
+
+        if (thread_count == 0) {
+            thread_count = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+        }
+
+        m_stopping = false;
+        m_generation = 0;
+        m_pending_workers = 0;
+
+        m_loop = nullptr;
+        m_user_data = nullptr;
+        m_count = m_grain = 0;
+        m_next_chunk = 0;
+
+        for (size_t i = 1; i < thread_count; i++) {
+            m_workers.emplace_back([this, i]() { worker(i); });
+        }
+    }
+
+    thread_pool::~thread_pool() {
+        ZoneScoped;
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_stopping = true;
+        }
+
+        m_work_available.notify_all();
+        for (auto& thread : m_workers) {
+            thread.join();
+        }
+    }
+
+    void thread_pool::dispatch(size_t count, size_t grain, loop_t loop, const void* user_data) {
+        ZoneScoped;
+
+        if (count == 0) {
+            return;
+        }
+
+        grain = std::max<size_t>(grain, 1);
+        if (m_workers.empty() || count <= grain) {
+            loop(user_data, 0, count, 0);
+            return;
+        }
+
+        std::lock_guard dispatch_lock(m_dispatch_mutex);
+        {
+            std::lock_guard lock(m_mutex);
+
+            m_loop = loop;
+            m_user_data = user_data;
+            m_count = count;
+            m_grain = grain;
+            m_next_chunk = 0;
+            m_exception = nullptr;
+
+            m_pending_workers = m_workers.size();
+            m_generation++;
+        }
+
+        m_work_available.notify_all();
+        run_chunks(0);
+
+        std::exception_ptr exception;
+        {
+            std::unique_lock lock(m_mutex);
+            m_work_finished.wait(lock, [this]() { return m_pending_workers == 0; });
+
+            exception = m_exception;
+            m_exception = nullptr;
+        }
+
+        if (exception) {
+            std::rethrow_exception(exception);
+        }
+    }
+
+    void thread_pool::run_chunks(size_t thread_index) {
+        ZoneScoped;
+
+        try {
+            while (true) {
+                size_t begin = m_next_chunk.fetch_add(m_grain);
+                if (begin >= m_count) {
+                    break;
+                }
+
+                size_t end = std::min(begin + m_grain, m_count);
+                m_loop(m_user_data, begin, end, thread_index);
+            }
+        } catch (...) {
+            // skip the remaining chunks and hand the first exception to the dispatching thread
+            m_next_chunk = m_count;
+
+            std::lock_guard lock(m_mutex);
+            if (!m_exception) {
+                m_exception = std::current_exception();
+            }
+        }
+    }
+
+    void thread_pool::worker(size_t thread_index) {
+        uint64_t generation = 0;
+        while (true) {
+            {
+                std::unique_lock lock(m_mutex);
+                m_work_available.wait(lock, [&]() {
+                    return m_stopping || m_generation != generation;
+                });
+
+                if (m_stopping) {
+                    return;
+                }
+
+                generation = m_generation;
+            }
+
+            run_chunks(thread_index);
+
+            std::lock_guard lock(m_mutex);
+            if (--m_pending_workers == 0) {
+                m_work_finished.notify_one();
+            }
+        }
+    }
+} // namespace neuralnet
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+namespace neuralnet {
+    // persistent set of worker threads for data-parallel loops
+    // the thread calling parallel_for participates as thread 0, so a pool of n threads spawns n - 1
+    // workers
+    class NN_API thread_pool {
+    public:
+        // 0 chooses the hardware concurrency of the host
+        thread_pool(size_t thread_count = 0);
+        ~thread_pool();
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        size_t get_thread_count() const { return m_workers.size() + 1; }
+
+        // calls func(begin, end, thread_index) over [0, count) in chunks of at most grain elements,
+        // and blocks until every chunk has finished. thread_index is less than get_thread_count()
+        // does not allocate; only one loop runs on the pool at a time
+        template <typename F>
+        void parallel_for(size_t count, size_t grain, const F& func) {
+            dispatch(count, grain, &invoke_loop<F>, &func);
+        }
+
+    private:
+        using loop_t = void (*)(const void* user_data, size_t begin, size_t end,
+                                size_t thread_index);
+
+        template <typename F>
+        static void invoke_loop(const void* user_data, size_t begin, size_t end,
+                                size_t thread_index) {
+            (*(const F*)user_data)(begin, end, thread_index);
+        }
+
+        void dispatch(size_t count, size_t grain, loop_t loop, const void* user_data);
+        void run_chunks(size_t thread_index);
+        void worker(size_t thread_index);
+
+        std::vector<std::thread> m_workers;
+        std::mutex m_dispatch_mutex, m_mutex;
+        std::condition_variable m_work_available, m_work_finished;
+
+        bool m_stopping;
+        uint64_t m_generation;
+        size_t m_pending_workers;
+
+        loop_t m_loop;
+        const void* m_user_data;
+        size_t m_count, m_grain;
+        std::atomic<size_t> m_next_chunk;
+        std::exception_ptr m_exception;
+    };
+} // namespace neuralnet
\ No newline at end of file
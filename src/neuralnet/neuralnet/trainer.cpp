@@ -28,6 +28,7 @@ namespace neuralnet {
             stop();
         }
 
+        m_evaluator->release_plans(m_network);
         m_evaluator->set_training(false);
     }
 
@@ -77,6 +78,7 @@ namespace neuralnet {
 
         m_running = true;
         regenerate_training_cycle();
+        compile_plans();
 
         std::cout << "beginning training!" << std::endl;
     }
@@ -140,6 +142,7 @@ namespace neuralnet {
     void trainer::regenerate_training_cycle() {
         ZoneScoped;
         m_current_batch = 0;
+        m_prepared_batch.reset();
 
         m_training_cycle.resize((size_t)m_dataset->get_sample_count(dataset_group::training));
         for (size_t i = 0; i < m_training_cycle.size(); i++) {
@@ -153,34 +156,77 @@ namespace neuralnet {
         }
     }
 
-    void trainer::eval() {
+    // every batch the trainer evaluates has one of a handful of sizes: full training and eval
+    // batches, and whatever is left of each eval group at its end
+    void trainer::compile_plans() {
         ZoneScoped;
 
+        std::unordered_set<uint64_t> batch_sizes = { m_current_settings.batch_size,
+                                                     m_current_settings.eval_batch_size };
+
+        std::unordered_set<dataset_group> groups;
+        m_dataset->get_groups(groups);
+
+        for (auto group : { dataset_group::testing, dataset_group::evaluation }) {
+            if (groups.find(group) == groups.end() || m_current_settings.eval_batch_size == 0) {
+                continue;
+            }
+
+            uint64_t sample_count = m_dataset->get_sample_count(group);
+            batch_sizes.insert(sample_count % m_current_settings.eval_batch_size);
+        }
+
+        for (uint64_t batch_size : batch_sizes) {
+            if (batch_size > 0) {
+                m_evaluator->compile_plan(m_network, batch_size);
+            }
+        }
+    }
+
+    void trainer::prepare_batch(uint64_t batch) {
+        ZoneScoped;
+
+        if (m_prepared_batch == batch) {
+            return;
+        }
+
         uint64_t batch_size = m_current_settings.batch_size;
-        std::vector<number_t> batch_inputs, batch_outputs;
+        m_batch_inputs.clear();
+        m_batch_outputs.clear();
 
         for (uint64_t i = 0; i < batch_size; i++) {
-            uint64_t training_cycle_index = i + m_current_batch * batch_size;
+            uint64_t training_cycle_index = i + batch * batch_size;
             uint64_t sample_index = m_training_cycle[(size_t)training_cycle_index];
 
-            std::vector<number_t> inputs, outputs;
-            if (!m_dataset->get_sample(dataset_group::training, sample_index, inputs, outputs)) {
+            if (!m_dataset->get_sample(dataset_group::training, sample_index, m_sample_inputs,
+                                       m_sample_outputs)) {
                 throw std::runtime_error("failed to retrieve sample " +
                                          std::to_string(sample_index) + "!");
             }
 
-            batch_inputs.insert(batch_inputs.end(), inputs.begin(), inputs.end());
-            batch_outputs.insert(batch_outputs.end(), outputs.begin(), outputs.end());
+            m_batch_inputs.insert(m_batch_inputs.end(), m_sample_inputs.begin(),
+                                  m_sample_inputs.end());
+            m_batch_outputs.insert(m_batch_outputs.end(), m_sample_outputs.begin(),
+                                   m_sample_outputs.end());
         }
 
-        auto key = m_evaluator->begin_eval(m_network, batch_inputs);
+        m_prepared_batch = batch;
+    }
+
+    void trainer::eval() {
+        ZoneScoped;
+
+        prepare_batch(m_current_batch);
+        auto key = m_evaluator->begin_eval(m_network, m_batch_inputs);
         if (!key) {
             throw std::runtime_error("failed to begin evaluation!");
         }
 
-        uint64_t eval_key = key.value();
-        m_sample_map[eval_key] = batch_outputs;
-        m_current_eval_keys.push_back(eval_key);
+        // the next batch is gathered into the buffer this one leaves behind
+        std::swap(m_batch_outputs, m_backprop_data.expected_outputs);
+        m_prepared_batch.reset();
+
+        m_current_eval_keys.push_back(key.value());
     }
 
     void trainer::backprop() {
@@ -190,30 +236,27 @@ namespace neuralnet {
             return;
         }
 
-        std::vector eval_keys(m_current_eval_keys);
-        m_current_eval_keys.clear();
-
-        for (uint64_t eval_key : eval_keys) {
-            if (m_sample_map.find(eval_key) == m_sample_map.end()) {
-                throw std::runtime_error("failed to find sample expected outputs!");
-            }
-
-            backprop_data_t data;
-            data.expected_outputs = m_sample_map[eval_key];
+        // eval() only begins one evaluation per step
+        if (m_current_eval_keys.size() > 1) {
+            throw std::runtime_error("more than one evaluation per training step!");
+        }
 
-            if (!m_evaluator->get_eval_result(eval_key, &data.eval_outputs)) {
+        m_backprop_keys.clear();
+        for (uint64_t eval_key : m_current_eval_keys) {
+            if (!m_evaluator->get_eval_result(eval_key, &m_backprop_data.eval_outputs)) {
                 throw std::runtime_error("failed to retrieve eval result!");
             }
 
-            auto key = m_evaluator->begin_backprop(m_network, data);
+            auto key = m_evaluator->begin_backprop(m_network, m_backprop_data);
             if (!key) {
                 throw std::runtime_error("failed to begin backpropagation!");
             }
 
-            m_sample_map.erase(eval_key);
             m_evaluator->free_result(eval_key);
-            m_current_eval_keys.push_back(key.value());
+            m_backprop_keys.push_back(key.value());
         }
+
+        std::swap(m_current_eval_keys, m_backprop_keys);
     }
 
     bool trainer::compose_deltas() {
@@ -223,18 +266,19 @@ namespace neuralnet {
         auto& layers = m_network->get_layers();
         size_t layer_count = layers.size();
 
-        delta_composition_data_t data;
+        auto& data = m_composition_data;
         data.delta_scalar = m_current_settings.learning_rate / m_current_settings.batch_size;
         data.nn = m_network;
-        data.backprop_keys = m_current_eval_keys;
         data.copy = is_last_batch;
 
+        std::swap(data.backprop_keys, m_current_eval_keys);
+        m_current_eval_keys.clear();
+
         m_evaluator->compose_deltas(data);
-        for (uint64_t key : m_current_eval_keys) {
+        for (uint64_t key : data.backprop_keys) {
             m_evaluator->free_result(key);
         }
 
-        m_current_eval_keys.clear();
         return is_last_batch;
     }
 
@@ -248,6 +292,11 @@ namespace neuralnet {
             }
 
             if (should_wait) {
+                // gather the next batch while the evaluator works on this one
+                if (m_current_batch + 1 < m_batch_count) {
+                    prepare_batch(m_current_batch + 1);
+                }
+
                 return false;
             } else if (!m_current_eval_keys.empty()) {
                 switch (m_stage) {
@@ -288,6 +337,9 @@ namespace neuralnet {
     bool trainer::check_eval_keys() {
         ZoneScoped;
 
+        // the output layer decides which cost the network is trained against
+        auto output_function = m_network->get_layers().back().function;
+
         std::vector<number_t> costs;
         for (uint64_t key : m_current_eval_keys) {
             void* output;
@@ -304,7 +356,9 @@ namespace neuralnet {
 
             const auto& expected_outputs = m_sample_map[key];
             for (size_t i = 0; i < outputs.size(); i++) {
-                number_t cost = m_evaluator->cost_function(outputs[i], expected_outputs[i]);
+                number_t cost =
+                    m_evaluator->cost_function(outputs[i], expected_outputs[i], output_function);
+
                 costs.push_back(cost);
             }
 
@@ -327,7 +381,15 @@ namespace neuralnet {
                 return false;
             }
 
+            // the batch begun by the previous call has finished
             m_current_eval_index += batch_size;
+            for (uint64_t key : m_current_eval_keys) {
+                m_evaluator->free_result(key);
+            }
+
+            m_current_eval_keys.clear();
+            batch_size =
+                std::min(sample_count - m_current_eval_index, m_current_settings.eval_batch_size);
         }
 
         if (batch_size == 0) {
@@ -56,6 +56,8 @@ namespace neuralnet {
         };
 
         void regenerate_training_cycle();
+        void prepare_batch(uint64_t batch);
+        void compile_plans();
 
         void eval();
         void backprop();
@@ -78,6 +80,17 @@ namespace neuralnet {
         std::unordered_map<uint64_t, std::vector<number_t>> m_sample_map;
         std::vector<uint64_t> m_training_cycle;
 
+        // samples gathered ahead of time, while the evaluator is busy
+        std::optional<uint64_t> m_prepared_batch;
+        std::vector<number_t> m_batch_inputs, m_batch_outputs;
+        std::vector<number_t> m_sample_inputs, m_sample_outputs;
+
+        // reused from batch to batch, so that a training step does not allocate
+        // m_backprop_data holds the expected outputs of the batch being evaluated
+        backprop_data_t m_backprop_data;
+        delta_composition_data_t m_composition_data;
+        std::vector<uint64_t> m_backprop_keys;
+
         dataset_group m_phase;
         training_stage m_stage;
         std::vector<uint64_t> m_current_eval_keys;
@@ -2,13 +2,19 @@
 #define NN_PCH_INCLUDED
 
 #include <vector>
+#include <array>
+#include <algorithm>
+#include <limits>
+#include <cmath>
 #include <string>
 #include <cstdint>
 #include <cstring>
 #include <stdexcept>
+#include <map>
 #include <unordered_map>
 #include <unordered_set>
 #include <optional>
+#include <span>
 #include <memory>
 #include <random>
 #include <type_traits>
@@ -17,6 +23,11 @@
 #include <fstream>
 #include <sstream>
 #include <functional>
+#include <tuple>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 #if __has_include(<filesystem>)
 #include <filesystem>
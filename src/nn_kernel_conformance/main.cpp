@@ -0,0 +1,1150 @@
+// checks every kernel and evaluator variant built into neuralnet against double precision math
+// kernels are compared one by one with the same function evaluated in double. evaluators run
+// random networks and batches in every configuration they support, plus a fixed network split
+// across a pool of several threads, and their outputs and gradients are compared with a double
+// precision evaluation of the same network, whose gradient is in turn checked against central
+// finite differences
+// every check reports its largest distance in ulp and its largest relative error. values much
+// smaller than the rest of their array are measured against the array's scale, see get_scale
+//
+// usage: nn_kernel_conformance [trials] [seed]
+// exits with 1 if any check is past its tolerance
+
+#include <neuralnet.h>
+
+#ifdef NN_SUPPORT_vulkan
+#include <volk.h>
+#endif
+
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+namespace evaluators = neuralnet::evaluators;
+using neuralnet::activation_function;
+using neuralnet::number_t;
+using neuralnet::parameter_format;
+
+// tolerances on the relative error of kernels. sums are measured against the sum of the
+// magnitudes of their terms, activation functions against the bounds in cpu_kernels.h
+static constexpr double s_sum_tolerance = 1e-5;
+static constexpr double s_element_tolerance = 1e-6;
+static constexpr double s_sigmoid_tolerance = 2e-7;
+static constexpr double s_fast_sigmoid_tolerance = 3e-5;
+static constexpr double s_table_sigmoid_tolerance = 1e-6;
+
+// gelu's derivative is computed from its inputs, and loses a little more
+static constexpr double s_gelu_gradient_tolerance = 5e-6;
+
+// tolerance of the reference gradient against central differences with a step of
+// s_finite_difference_step, which are limited by the rounding of the cost they subtract
+static constexpr double s_finite_difference_step = 1e-6;
+static constexpr double s_finite_difference_tolerance = 1e-3;
+
+// values smaller than this fraction of the largest value of their array are measured against it
+static constexpr double s_scale_fraction = 1e-2;
+
+// gradients are composed scaled by this, so that they stay well clear of the rounding of the
+// parameters they are added to. a power of two, so that scaling back is exact
+static constexpr float s_delta_scalar = 1024;
+
+static constexpr size_t s_kernel_counts[] = { 1, 2, 3, 7, 8, 9, 15, 16, 17, 31, 33, 64, 100, 257 };
+
+static constexpr evaluators::cpu_isa s_isas[] = { evaluators::cpu_isa::scalar,
+                                                  evaluators::cpu_isa::sse42,
+                                                  evaluators::cpu_isa::avx2,
+                                                  evaluators::cpu_isa::avx512 };
+
+static constexpr parameter_format s_formats[] = { parameter_format::fp32, parameter_format::fp16,
+                                                  parameter_format::bf16 };
+
+// largest errors seen by one check, see add_error
+struct max_error_t {
+    uint64_t ulp = 0;
+    double relative = 0;
+};
+
+struct check_t {
+    std::string name;
+    double tolerance;
+    max_error_t error;
+};
+
+// reported in the order they are first used. a deque, so that references stay valid
+static std::deque<check_t> s_checks;
+
+static max_error_t& get_check(const std::string& name, double tolerance) {
+    for (auto& check : s_checks) {
+        if (check.name == name) {
+            return check.error;
+        }
+    }
+
+    s_checks.push_back({ name, tolerance, {} });
+    return s_checks.back().error;
+}
+
+// distance between two values in units in the last place of _Ty
+template <typename _Ty>
+static uint64_t get_ulp_distance(_Ty a, _Ty b) {
+    using bits_t = std::conditional_t<sizeof(_Ty) == sizeof(int32_t), int32_t, int64_t>;
+
+    if (std::isnan(a) || std::isnan(b)) {
+        return std::numeric_limits<uint64_t>::max();
+    }
+
+    // maps the bits of negative values below those of positive ones, so that adjacent values
+    // are one apart and both zeroes meet
+    auto order = [](_Ty value) {
+        auto bits = std::bit_cast<bits_t>(value);
+        return bits < 0 ? (int64_t)std::numeric_limits<bits_t>::min() - bits : (int64_t)bits;
+    };
+
+    int64_t x = order(a);
+    int64_t y = order(b);
+
+    // the true distance always fits, even where the signed one would overflow
+    return x > y ? (uint64_t)x - (uint64_t)y : (uint64_t)y - (uint64_t)x;
+}
+
+// errors of values smaller in magnitude than scale are measured against scale instead
+template <typename _Ty>
+static void add_error(max_error_t& error, _Ty actual, double expected, double scale) {
+    if (!std::isfinite(expected)) {
+        return;
+    }
+
+    if (!std::isfinite(actual)) {
+        error.ulp = std::numeric_limits<uint64_t>::max();
+        error.relative = std::numeric_limits<double>::infinity();
+        return;
+    }
+
+    error.ulp = std::max(error.ulp, get_ulp_distance(actual, (_Ty)expected));
+
+    double difference = std::abs((double)actual - expected);
+    double magnitude = std::max(std::abs(expected), scale);
+
+    if (magnitude > 0) {
+        error.relative = std::max(error.relative, difference / magnitude);
+    } else if (difference > 0) {
+        error.relative = std::numeric_limits<double>::infinity();
+    }
+}
+
+// integer kernels have to match exactly. the distance is reported as ulp
+static void add_exact_error(max_error_t& error, int64_t actual, int64_t expected) {
+    uint64_t difference = (uint64_t)std::abs(actual - expected);
+
+    error.ulp = std::max(error.ulp, difference);
+    error.relative = std::max(error.relative, (double)difference / std::max(std::abs(expected),
+                                                                            (int64_t)1));
+}
+
+static double get_scale(const std::vector<double>& values) {
+    double maximum = 0;
+    for (double value : values) {
+        maximum = std::max(maximum, std::abs(value));
+    }
+
+    return maximum * s_scale_fraction;
+}
+
+static std::vector<number_t> random_values(size_t count, number_t min, number_t max) {
+    std::vector<number_t> values(count);
+    for (auto& value : values) {
+        value = neuralnet::random::next(min, max);
+    }
+
+    return values;
+}
+
+static const char* get_function_name(activation_function function) {
+    switch (function) {
+    case activation_function::sigmoid:
+        return "sigmoid";
+    case activation_function::relu:
+        return "relu";
+    case activation_function::leaky_relu:
+        return "leaky_relu";
+    case activation_function::tanh:
+        return "tanh";
+    case activation_function::gelu:
+        return "gelu";
+    case activation_function::identity:
+        return "identity";
+    case activation_function::softmax:
+        return "softmax";
+    default:
+        return "unknown";
+    }
+}
+
+static const char* get_accuracy_name(evaluators::cpu_activation_accuracy accuracy) {
+    switch (accuracy) {
+    case evaluators::cpu_activation_accuracy::precise:
+        return "precise";
+    case evaluators::cpu_activation_accuracy::fast:
+        return "fast";
+    case evaluators::cpu_activation_accuracy::table:
+        return "table";
+    default:
+        return "unknown";
+    }
+}
+
+// da/dz of every activation function but softmax, in double precision
+static double get_derivative(activation_function function, double z, double a) {
+    switch (function) {
+    case activation_function::sigmoid:
+        return a * (1 - a);
+    case activation_function::relu:
+        return z > 0 ? 1 : 0;
+    case activation_function::leaky_relu:
+        return z > 0 ? 1 : (double)neuralnet::leaky_relu_slope;
+    case activation_function::tanh:
+        return 1 - a * a;
+    case activation_function::gelu: {
+        double scale = neuralnet::gelu_scale;
+        double cubic = neuralnet::gelu_cubic;
+        double s = 1 / (1 + std::exp(-scale * (z + cubic * z * z * z)));
+
+        return s + z * s * (1 - s) * scale * (1 + 3 * cubic * z * z);
+    }
+    case activation_function::identity:
+        return 1;
+    default:
+        throw std::runtime_error("invalid activation function!");
+    }
+}
+
+// compares a kernel's outputs y for inputs x with the activation function in double precision
+static void check_activation(const std::string& name, double tolerance,
+                             activation_function function, const std::vector<number_t>& x,
+                             const std::vector<number_t>& y) {
+    std::vector<double> expected(x.begin(), x.end());
+    neuralnet::activate(function, expected.data(), expected.size());
+
+    auto& error = get_check(name, tolerance);
+    for (size_t i = 0; i < x.size(); i++) {
+        add_error(error, y[i], expected[i], 1.0);
+    }
+}
+
+// compares a gradient kernel's outputs with dy scaled by da/dz, for inputs x with outputs a
+static void check_gradient(const std::string& name, double tolerance,
+                           activation_function function, const std::vector<number_t>& x,
+                           const std::vector<number_t>& a, const std::vector<number_t>& dy,
+                           const std::vector<number_t>& result) {
+    auto& error = get_check(name, tolerance);
+    for (size_t i = 0; i < x.size(); i++) {
+        double expected = dy[i] * get_derivative(function, x[i], a[i]);
+        add_error(error, result[i], expected, std::abs(dy[i]));
+    }
+}
+
+static void check_kernels(const evaluators::cpu_kernels_t& kernels) {
+    std::string prefix = std::string("kernels ") + evaluators::get_cpu_isa_name(kernels.isa) + " ";
+
+    for (size_t count : s_kernel_counts) {
+        auto a = random_values(count, -1, 1);
+        auto b = random_values(count, -1, 1);
+
+        double sum = 0;
+        double scale = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            sum += (double)a[i] * b[i];
+            scale += std::abs((double)a[i] * b[i]);
+        }
+
+        add_error(get_check(prefix + "dot", s_sum_tolerance),
+                  kernels.dot(a.data(), b.data(), count), sum, scale);
+
+        // against the 16-bit values widened back, so that only the kernel's own error counts
+        std::vector<uint16_t> reduced(count);
+        std::vector<number_t> widened(count);
+
+        for (auto format : { parameter_format::fp16, parameter_format::bf16 }) {
+            neuralnet::reduce_parameters(b.data(), reduced.data(), count, format);
+            neuralnet::widen_parameters(reduced.data(), widened.data(), count, format);
+
+            sum = 0;
+            scale = 0;
+
+            for (size_t i = 0; i < count; i++) {
+                sum += (double)a[i] * widened[i];
+                scale += std::abs((double)a[i] * widened[i]);
+            }
+
+            auto dot = format == parameter_format::fp16 ? kernels.dot_f16 : kernels.dot_bf16;
+            std::string name = prefix + "dot_" + neuralnet::get_parameter_format_name(format);
+
+            add_error(get_check(name, s_sum_tolerance), dot(a.data(), reduced.data(), count), sum,
+                      scale);
+        }
+
+        // every other column of a row twice as wide, give or take one
+        std::vector<uint32_t> indices(count);
+        for (size_t i = 0; i < count; i++) {
+            indices[i] = (uint32_t)(i * 2 + neuralnet::random::next<size_t>(0, 1));
+        }
+
+        for (size_t width : { 1, 3, 8, 17 }) {
+            auto x = random_values(count * 2 * width, -1, 1);
+            std::vector<number_t> y(width);
+
+            kernels.sparse_dot_interleaved(a.data(), indices.data(), x.data(), count, y.data(),
+                                           width);
+
+            auto& error = get_check(prefix + "sparse_dot_interleaved", s_sum_tolerance);
+            for (size_t j = 0; j < width; j++) {
+                sum = 0;
+                scale = 0;
+
+                for (size_t i = 0; i < count; i++) {
+                    double term = (double)a[i] * x[indices[i] * width + j];
+
+                    sum += term;
+                    scale += std::abs(term);
+                }
+
+                add_error(error, y[j], sum, scale);
+
+                // the first vector doubles as the input of sparse_dot
+                if (width == 1) {
+                    add_error(get_check(prefix + "sparse_dot", s_sum_tolerance),
+                              kernels.sparse_dot(a.data(), indices.data(), x.data(), count), sum,
+                              scale);
+                }
+            }
+        }
+
+        number_t alpha = neuralnet::random::next<number_t>(-2, 2);
+        auto y = b;
+
+        kernels.axpy(alpha, a.data(), y.data(), count);
+        auto& axpy_error = get_check(prefix + "axpy", s_element_tolerance);
+
+        for (size_t i = 0; i < count; i++) {
+            double product = (double)alpha * a[i];
+            add_error(axpy_error, y[i], b[i] + product, std::abs(b[i]) + std::abs(product));
+        }
+
+        // activation functions, over and past the range the table sigmoid covers
+        auto x = random_values(count, -20, 20);
+        auto dy = random_values(count, -1, 1);
+        std::vector<number_t> outputs(count), gradient(count);
+
+        kernels.sigmoid(x.data(), outputs.data(), count);
+        check_activation(prefix + "sigmoid", s_sigmoid_tolerance, activation_function::sigmoid, x,
+                         outputs);
+
+        gradient = dy;
+        kernels.sigmoid_gradient(outputs.data(), gradient.data(), count);
+        check_gradient(prefix + "sigmoid_gradient", s_element_tolerance,
+                       activation_function::sigmoid, x, outputs, dy, gradient);
+
+        kernels.fast_sigmoid(x.data(), outputs.data(), count);
+        check_activation(prefix + "fast_sigmoid", s_fast_sigmoid_tolerance,
+                         activation_function::sigmoid, x, outputs);
+
+        kernels.table_sigmoid(x.data(), outputs.data(), count);
+        check_activation(prefix + "table_sigmoid", s_table_sigmoid_tolerance,
+                         activation_function::sigmoid, x, outputs);
+
+        kernels.relu(x.data(), outputs.data(), count);
+        check_activation(prefix + "relu", s_element_tolerance, activation_function::relu, x,
+                         outputs);
+
+        gradient = dy;
+        kernels.relu_gradient(outputs.data(), gradient.data(), count);
+        check_gradient(prefix + "relu_gradient", s_element_tolerance, activation_function::relu, x,
+                       outputs, dy, gradient);
+
+        auto slope = (number_t)neuralnet::leaky_relu_slope;
+        kernels.leaky_relu(x.data(), outputs.data(), count, slope);
+        check_activation(prefix + "leaky_relu", s_element_tolerance,
+                         activation_function::leaky_relu, x, outputs);
+
+        gradient = dy;
+        kernels.leaky_relu_gradient(outputs.data(), gradient.data(), count, slope);
+        check_gradient(prefix + "leaky_relu_gradient", s_element_tolerance,
+                       activation_function::leaky_relu, x, outputs, dy, gradient);
+
+        kernels.tanh(x.data(), outputs.data(), count);
+        check_activation(prefix + "tanh", s_sigmoid_tolerance, activation_function::tanh, x,
+                         outputs);
+
+        gradient = dy;
+        kernels.tanh_gradient(outputs.data(), gradient.data(), count);
+        check_gradient(prefix + "tanh_gradient", s_element_tolerance, activation_function::tanh, x,
+                       outputs, dy, gradient);
+
+        kernels.gelu(x.data(), outputs.data(), count);
+        check_activation(prefix + "gelu", s_element_tolerance, activation_function::gelu, x,
+                         outputs);
+
+        gradient = dy;
+        kernels.gelu_gradient(x.data(), gradient.data(), count);
+        check_gradient(prefix + "gelu_gradient", s_gelu_gradient_tolerance,
+                       activation_function::gelu, x, outputs, dy, gradient);
+
+        x = random_values(count, -30, 30);
+        kernels.softmax(x.data(), outputs.data(), count);
+        check_activation(prefix + "softmax", s_element_tolerance, activation_function::softmax, x,
+                         outputs);
+
+        // quantized against the same single precision product, as rounding is all there is to it
+        std::vector<int8_t> quantized(count);
+        number_t inverse_scale = 127.0f / 1.5f;
+
+        for (number_t minimum : { -127.0f, 0.0f }) {
+            kernels.quantize_i8(a.data(), quantized.data(), count, inverse_scale, minimum);
+
+            auto& error = get_check(prefix + "quantize_i8", 0);
+            for (size_t i = 0; i < count; i++) {
+                number_t value = std::clamp(a[i] * inverse_scale, minimum, 127.0f);
+                add_exact_error(error, quantized[i], (int64_t)std::nearbyint(value));
+            }
+        }
+
+        std::vector<int8_t> signed_a(count), signed_b(count);
+        std::vector<uint8_t> unsigned_a(count);
+
+        int64_t signed_sum = 0;
+        int64_t unsigned_sum = 0;
+
+        for (size_t i = 0; i < count; i++) {
+            signed_a[i] = (int8_t)neuralnet::random::next<int32_t>(-127, 127);
+            signed_b[i] = (int8_t)neuralnet::random::next<int32_t>(-127, 127);
+            unsigned_a[i] = (uint8_t)neuralnet::random::next<int32_t>(0, 127);
+
+            signed_sum += (int64_t)signed_a[i] * signed_b[i];
+            unsigned_sum += (int64_t)unsigned_a[i] * signed_b[i];
+        }
+
+        add_exact_error(get_check(prefix + "dot_i8", 0),
+                        kernels.dot_i8(signed_a.data(), signed_b.data(), count), signed_sum);
+
+        add_exact_error(get_check(prefix + "dot_u8i8", 0),
+                        kernels.dot_u8i8(unsigned_a.data(), signed_b.data(), count), unsigned_sum);
+    }
+}
+
+struct batch_t {
+    size_t passes;
+    std::vector<number_t> inputs, expected_outputs;
+};
+
+// a network's outputs and gradient, evaluated in double precision
+struct reference_t {
+    std::vector<double> outputs;
+
+    // of the cost summed over the batch, as backprop computes it
+    std::vector<std::vector<double>> bias_gradients, weight_gradients;
+};
+
+// returns the cost of the batch, see basic_evaluator::cost_function. fills reference, if given,
+// and counts the pre-activations on the flat side of relu and leaky_relu into inactive
+static double evaluate_reference(const neuralnet::basic_network<double>* nn, const batch_t& batch,
+                                 reference_t* reference, size_t* inactive = nullptr) {
+    const auto& layers = nn->get_layers();
+    uint64_t input_count = layers.front().previous_size;
+    uint64_t output_count = layers.back().size;
+    auto output_function = layers.back().function;
+
+    if (reference != nullptr) {
+        reference->outputs.clear();
+        reference->bias_gradients.resize(layers.size());
+        reference->weight_gradients.resize(layers.size());
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            reference->bias_gradients[i].assign(layers[i].biases.size(), 0);
+            reference->weight_gradients[i].assign(layers[i].weights.size(), 0);
+        }
+    }
+
+    // activations[i] holds the inputs of layer i
+    std::vector<std::vector<double>> z(layers.size()), activations(layers.size() + 1);
+    std::vector<double> deltas, previous_deltas;
+    double cost = 0;
+
+    if (inactive != nullptr) {
+        *inactive = 0;
+    }
+
+    for (size_t pass = 0; pass < batch.passes; pass++) {
+        const number_t* inputs = &batch.inputs[pass * input_count];
+        activations[0].assign(inputs, inputs + input_count);
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            const auto& layer = layers[i];
+            z[i].resize(layer.size);
+
+            for (uint64_t c = 0; c < layer.size; c++) {
+                double value = layer.biases[c];
+                for (uint64_t p = 0; p < layer.previous_size; p++) {
+                    value += layer.weights[c * layer.previous_size + p] * activations[i][p];
+                }
+
+                z[i][c] = value;
+            }
+
+            bool kinked = layer.function == activation_function::relu ||
+                          layer.function == activation_function::leaky_relu;
+
+            if (kinked && inactive != nullptr) {
+                *inactive += (size_t)std::count_if(z[i].begin(), z[i].end(),
+                                                   [](double value) { return value <= 0; });
+            }
+
+            activations[i + 1] = z[i];
+            neuralnet::activate(layer.function, activations[i + 1].data(), layer.size);
+        }
+
+        // dC/dz of the output layer. softmax is scored by cross-entropy, everything else by
+        // squared error
+        const auto& outputs = activations.back();
+        const number_t* expected = &batch.expected_outputs[pass * output_count];
+
+        double expected_sum = 0;
+        for (uint64_t c = 0; c < output_count; c++) {
+            expected_sum += expected[c];
+        }
+
+        deltas.resize(output_count);
+        for (uint64_t c = 0; c < output_count; c++) {
+            if (output_function == activation_function::softmax) {
+                if (expected[c] != 0) {
+                    cost -= expected[c] * std::log(outputs[c]);
+                }
+
+                deltas[c] = outputs[c] * expected_sum - expected[c];
+            } else {
+                double difference = outputs[c] - expected[c];
+                cost += difference * difference;
+
+                deltas[c] =
+                    2 * difference * get_derivative(output_function, z.back()[c], outputs[c]);
+            }
+        }
+
+        if (reference == nullptr) {
+            continue;
+        }
+
+        reference->outputs.insert(reference->outputs.end(), outputs.begin(), outputs.end());
+        for (size_t i = layers.size(); i-- > 0;) {
+            const auto& layer = layers[i];
+            const auto& previous_activations = activations[i];
+
+            auto& bias_gradient = reference->bias_gradients[i];
+            auto& weight_gradient = reference->weight_gradients[i];
+            previous_deltas.assign(layer.previous_size, 0);
+
+            for (uint64_t c = 0; c < layer.size; c++) {
+                bias_gradient[c] += deltas[c];
+
+                for (uint64_t p = 0; p < layer.previous_size; p++) {
+                    uint64_t index = c * layer.previous_size + p;
+
+                    weight_gradient[index] += deltas[c] * previous_activations[p];
+                    previous_deltas[p] += layer.weights[index] * deltas[c];
+                }
+            }
+
+            if (i > 0) {
+                auto previous_function = layers[i - 1].function;
+                for (uint64_t p = 0; p < layer.previous_size; p++) {
+                    previous_deltas[p] *=
+                        get_derivative(previous_function, z[i - 1][p], previous_activations[p]);
+                }
+
+                std::swap(deltas, previous_deltas);
+            }
+        }
+    }
+
+    return cost;
+}
+
+// errors of one layer's gradient are measured against the scale of all of it
+static double get_gradient_scale(const reference_t& reference, size_t layer) {
+    return std::max(get_scale(reference.bias_gradients[layer]),
+                    get_scale(reference.weight_gradients[layer]));
+}
+
+// checks a sample of the reference gradient against central differences of the cost. samples
+// whose step moves a pre-activation across the kink of relu or leaky_relu are skipped, as the
+// difference is meaningless there
+static void check_reference_gradient(neuralnet::basic_network<double>* nn, const batch_t& batch,
+                                     const reference_t& reference) {
+    static constexpr size_t samples_per_layer = 16;
+
+    auto& error = get_check("reference finite differences", s_finite_difference_tolerance);
+    auto& layers = nn->get_layers();
+
+    auto check_parameter = [&](double& parameter, double expected, double scale) {
+        double original = parameter;
+        double step = s_finite_difference_step * std::max(1.0, std::abs(original));
+        size_t inactive_above, inactive_below;
+
+        parameter = original + step;
+        double above = evaluate_reference(nn, batch, nullptr, &inactive_above);
+
+        parameter = original - step;
+        double below = evaluate_reference(nn, batch, nullptr, &inactive_below);
+
+        parameter = original;
+        if (inactive_above == inactive_below) {
+            add_error(error, (above - below) / (2 * step), expected, scale);
+        }
+    };
+
+    for (size_t i = 0; i < layers.size(); i++) {
+        auto& layer = layers[i];
+        double scale = get_gradient_scale(reference, i);
+
+        size_t stride = std::max(layer.biases.size() / samples_per_layer, (size_t)1);
+        for (size_t c = 0; c < layer.biases.size(); c += stride) {
+            check_parameter(layer.biases[c], reference.bias_gradients[i][c], scale);
+        }
+
+        stride = std::max(layer.weights.size() / samples_per_layer, (size_t)1);
+        for (size_t w = 0; w < layer.weights.size(); w += stride) {
+            check_parameter(layer.weights[w], reference.weight_gradients[i][w], scale);
+        }
+    }
+}
+
+template <typename _Ty>
+static void wait_for_result(const neuralnet::basic_evaluator<_Ty>* evaluator, uint64_t result) {
+    while (!evaluator->is_result_ready(result)) {
+        std::this_thread::yield();
+    }
+}
+
+// evaluates the batch outside of and in training, and compares the outputs with the reference.
+// if gradient is set, also backpropagates the training evaluation and compares the gradient it
+// composes. the network's parameters are restored afterwards, but not any copy of them the
+// evaluator keeps
+template <typename _Ty>
+static void check_evaluator(neuralnet::basic_evaluator<_Ty>* evaluator,
+                            neuralnet::basic_network<_Ty>* nn, const batch_t& batch,
+                            const reference_t& reference, max_error_t& forward,
+                            max_error_t* gradient) {
+    using evaluator_type = neuralnet::basic_evaluator<_Ty>;
+
+    std::vector<_Ty> inputs(batch.inputs.begin(), batch.inputs.end());
+    std::vector<_Ty> outputs;
+    double output_scale = get_scale(reference.outputs);
+
+    for (bool training : { false, true }) {
+        evaluator->set_training(training);
+
+        auto eval_key = evaluator->begin_eval(nn, inputs);
+        if (!eval_key) {
+            throw std::runtime_error("failed to begin evaluation!");
+        }
+
+        wait_for_result(evaluator, eval_key.value());
+
+        void* native_outputs;
+        if (!evaluator->get_eval_result(eval_key.value(), &native_outputs)) {
+            throw std::runtime_error("failed to retrieve eval result!");
+        }
+
+        evaluator->retrieve_eval_values(nn, native_outputs, outputs);
+        if (outputs.size() != reference.outputs.size()) {
+            throw std::runtime_error("evaluator returned the wrong number of outputs!");
+        }
+
+        for (size_t i = 0; i < outputs.size(); i++) {
+            add_error(forward, outputs[i], reference.outputs[i], output_scale);
+        }
+
+        if (!training || gradient == nullptr) {
+            evaluator->free_result(eval_key.value());
+            continue;
+        }
+
+        typename evaluator_type::backprop_data_type backprop_data;
+        backprop_data.eval_outputs = native_outputs;
+        backprop_data.expected_outputs.assign(batch.expected_outputs.begin(),
+                                              batch.expected_outputs.end());
+
+        auto backprop_key = evaluator->begin_backprop(nn, backprop_data);
+        evaluator->free_result(eval_key.value());
+
+        if (!backprop_key) {
+            throw std::runtime_error("failed to begin backpropagation!");
+        }
+
+        wait_for_result(evaluator, backprop_key.value());
+        auto layers = nn->get_layers();
+
+        typename evaluator_type::delta_composition_data_type composition;
+        composition.nn = nn;
+        composition.backprop_keys = { backprop_key.value() };
+        composition.delta_scalar = s_delta_scalar;
+        composition.copy = true;
+
+        if (!evaluator->compose_deltas(composition)) {
+            throw std::runtime_error("failed to compose deltas!");
+        }
+
+        evaluator->free_result(backprop_key.value());
+        auto& composed = nn->get_layers();
+
+        for (size_t i = 0; i < layers.size(); i++) {
+            double scale = get_gradient_scale(reference, i);
+
+            for (size_t c = 0; c < layers[i].biases.size(); c++) {
+                double delta = (double)layers[i].biases[c] - composed[i].biases[c];
+                add_error(*gradient, (_Ty)(delta / s_delta_scalar),
+                          reference.bias_gradients[i][c], scale);
+            }
+
+            for (size_t w = 0; w < layers[i].weights.size(); w++) {
+                double delta = (double)layers[i].weights[w] - composed[i].weights[w];
+                add_error(*gradient, (_Ty)(delta / s_delta_scalar),
+                          reference.weight_gradients[i][w], scale);
+            }
+        }
+
+        composed = layers;
+    }
+}
+
+struct tolerance_t {
+    double forward, gradient;
+};
+
+// the fast and table sigmoids are approximations, see cpu_activation_accuracy. their error adds
+// up through every sigmoid layer of the network
+template <typename _Ty>
+static tolerance_t get_tolerance(evaluators::cpu_activation_accuracy accuracy) {
+    switch (accuracy) {
+    case evaluators::cpu_activation_accuracy::fast:
+        return { 5e-3, 5e-2 };
+    case evaluators::cpu_activation_accuracy::table:
+        return { 5e-4, 5e-3 };
+    default:
+        if constexpr (std::is_same_v<_Ty, double>) {
+            return { 1e-12, 1e-10 };
+        } else {
+            return { 1e-4, 1e-3 };
+        }
+    }
+}
+
+#ifdef NN_SUPPORT_cpu
+// how the sparse paths are forced: inputs are half zero, and weights of pruned networks too
+struct sparse_mode_t {
+    const char* name;
+    number_t input_threshold, weight_threshold;
+};
+
+static constexpr sparse_mode_t s_sparse_modes[] = { { "dense", 0, 0 },
+                                                    { "sparse-inputs", 0.75f, 0 },
+                                                    { "sparse-weights", 0, 0.75f } };
+
+static constexpr size_t s_checkpoint_intervals[] = { 0, 2 };
+
+static constexpr evaluators::cpu_activation_accuracy s_accuracies[] = {
+    evaluators::cpu_activation_accuracy::precise, evaluators::cpu_activation_accuracy::fast,
+    evaluators::cpu_activation_accuracy::table
+};
+
+// _Network is a basic_network<_Ty>, or one of the inference-only networks infer takes
+template <typename _Ty, typename _Network>
+static void check_infer(const evaluators::basic_cpu_evaluator<_Ty>& evaluator,
+                        const _Network* nn, const batch_t& batch, const reference_t& reference,
+                        max_error_t& error) {
+    const auto& layers = nn->get_layers();
+    uint64_t input_count = layers.front().previous_size;
+    uint64_t output_count = layers.back().size;
+
+    typename evaluators::basic_cpu_evaluator<_Ty>::workspace_type workspace;
+    std::vector<_Ty> inputs(input_count), outputs(output_count);
+    double scale = get_scale(reference.outputs);
+
+    for (size_t pass = 0; pass < batch.passes; pass++) {
+        const number_t* pass_inputs = &batch.inputs[pass * input_count];
+        std::copy(pass_inputs, pass_inputs + input_count, inputs.begin());
+
+        if (!evaluator.infer(nn, inputs, outputs, workspace)) {
+            throw std::runtime_error("failed to infer!");
+        }
+
+        for (uint64_t c = 0; c < output_count; c++) {
+            add_error(error, outputs[c], reference.outputs[pass * output_count + c], scale);
+        }
+    }
+}
+
+// runs the network through every instruction set, activation accuracy, sparse path and
+// checkpoint interval the evaluator supports, reading its weights in format
+template <typename _Ty>
+static void check_cpu_evaluator(evaluators::basic_cpu_evaluator<_Ty>& evaluator,
+                                const std::string& name, neuralnet::basic_network<_Ty>* nn,
+                                parameter_format format, const batch_t& batch,
+                                const reference_t& reference) {
+    for (auto isa : s_isas) {
+        if (!evaluator.set_kernel_isa(isa)) {
+            continue;
+        }
+
+        for (auto accuracy : s_accuracies) {
+            evaluator.set_activation_accuracy(accuracy);
+
+            auto tolerance = get_tolerance<_Ty>(accuracy);
+            std::string prefix = name + " " + evaluators::get_cpu_isa_name(isa) + " " +
+                                 get_accuracy_name(accuracy) + " ";
+
+            // infer always reads full precision weights, which are the rounded ones here
+            auto& infer_error = get_check(prefix + "infer", tolerance.forward);
+            check_infer(evaluator, nn, batch, reference, infer_error);
+
+            // the rounded weights reduce exactly, so a reduced copy sees the same network
+            if constexpr (std::is_same_v<_Ty, number_t>) {
+                if (format != parameter_format::fp32) {
+                    using neuralnet::reduced_network;
+                    auto reduced = neuralnet::unique(reduced_network::reduce(nn, format));
+                    std::string name =
+                        prefix + "infer " + neuralnet::get_parameter_format_name(format);
+
+                    auto& reduced_error = get_check(name, tolerance.forward);
+
+                    check_infer(evaluator, reduced.get(), batch, reference, reduced_error);
+                }
+            }
+
+            evaluator.set_parameter_format(format);
+            for (const auto& mode : s_sparse_modes) {
+                evaluator.set_sparse_input_threshold(mode.input_threshold);
+                evaluator.set_sparse_weight_threshold(mode.weight_threshold);
+
+                for (size_t interval : s_checkpoint_intervals) {
+                    evaluator.set_checkpoint_interval(interval);
+
+                    std::string variant = prefix + neuralnet::get_parameter_format_name(format) +
+                                          " " + mode.name;
+
+                    if (interval > 0) {
+                        variant += " checkpoint " + std::to_string(interval);
+                    }
+
+                    auto& forward = get_check(variant + " forward", tolerance.forward);
+                    auto& gradient = get_check(variant + " gradient", tolerance.gradient);
+
+                    check_evaluator(&evaluator, nn, batch, reference, forward, &gradient);
+                    evaluator.invalidate_weights(nn);
+                }
+            }
+
+            evaluator.set_parameter_format(parameter_format::fp32);
+        }
+    }
+
+    evaluator.set_sparse_input_threshold(0);
+    evaluator.set_sparse_weight_threshold(0);
+    evaluator.set_checkpoint_interval(0);
+}
+#endif
+
+#ifdef NN_SUPPORT_vulkan
+// cleared if the first vulkan evaluator fails to initialize
+static bool s_vulkan_available = true;
+
+// see evaluators::choose_evaluator
+static std::unique_ptr<evaluators::vulkan_evaluator> create_vulkan_evaluator(
+    parameter_format format) {
+    if (!evaluators::vulkan_evaluator::is_context_valid()) {
+        volkInitialize();
+
+        auto context = std::make_unique<evaluators::vulkan_context_t>();
+        context->vtable.vkGetInstanceProcAddr = vkGetInstanceProcAddr;
+
+        evaluators::vulkan_evaluator::set_next_context(std::move(context));
+    }
+
+    return std::make_unique<evaluators::vulkan_evaluator>(format);
+}
+
+// vulkan keeps networks on the gpu, so every network gets a new evaluator. deltas are composed
+// into 16-bit parameters in those formats, so only fp32 gradients are checked
+static void check_vulkan_evaluator(neuralnet::network* nn, parameter_format format,
+                                   const batch_t& batch, const reference_t& reference) {
+    if (!s_vulkan_available) {
+        return;
+    }
+
+    std::unique_ptr<evaluators::vulkan_evaluator> evaluator;
+    try {
+        evaluator = create_vulkan_evaluator(format);
+    } catch (const std::exception& exc) {
+        std::cout << "skipping vulkan: " << exc.what() << std::endl;
+
+        s_vulkan_available = false;
+        return;
+    }
+
+    // shaders have no accuracy tiers, and gpu exp is only loosely specified
+    auto tolerance = get_tolerance<number_t>(evaluators::cpu_activation_accuracy::table);
+    std::string variant = std::string("vulkan ") + neuralnet::get_parameter_format_name(format);
+
+    auto& forward = get_check(variant + " forward", tolerance.forward);
+    max_error_t* gradient = nullptr;
+
+    if (format == parameter_format::fp32) {
+        gradient = &get_check(variant + " gradient", tolerance.gradient);
+    }
+
+    check_evaluator<number_t>(evaluator.get(), nn, batch, reference, forward, gradient);
+}
+#endif
+
+// weights are scaled by 1 / sqrt(inputs), which keeps pre-activations within a few units
+static std::unique_ptr<neuralnet::network> randomize_network(
+    uint64_t input_count, const std::vector<neuralnet::layer_spec_t>& specs, bool pruned) {
+    auto nn = neuralnet::unique(neuralnet::network::randomize(input_count, specs));
+    for (auto& layer : nn->get_layers()) {
+        auto scale = (number_t)(1 / std::sqrt((double)layer.previous_size));
+        for (auto& weight : layer.weights) {
+            weight *= scale;
+        }
+    }
+
+    if (pruned) {
+        neuralnet::prune_weights_to_sparsity(nn.get(), 0.5);
+    }
+
+    return nn;
+}
+
+static std::unique_ptr<neuralnet::network> create_network(bool pruned) {
+    static constexpr activation_function functions[] = {
+        activation_function::sigmoid, activation_function::relu,
+        activation_function::leaky_relu, activation_function::tanh,
+        activation_function::gelu, activation_function::identity
+    };
+
+    static constexpr size_t function_count = sizeof(functions) / sizeof(functions[0]);
+
+    uint64_t input_count = neuralnet::random::next<uint64_t>(1, 64);
+    size_t layer_count = neuralnet::random::next<size_t>(1, 4);
+
+    std::vector<neuralnet::layer_spec_t> specs(layer_count);
+    for (size_t i = 0; i < layer_count; i++) {
+        auto& spec = specs[i];
+
+        spec.size = neuralnet::random::next<uint64_t>(1, 48);
+        spec.function = functions[neuralnet::random::next<size_t>(0, function_count - 1)];
+    }
+
+    // a third of the networks are classifiers
+    if (neuralnet::random::next<size_t>(0, 2) == 0) {
+        specs.back().function = activation_function::softmax;
+    }
+
+    return randomize_network(input_count, specs, pruned);
+}
+
+// the pool size and passes of the threaded trial. with several blocks of passes per thread, the
+// blocks run through the network at the same time
+static constexpr size_t s_threaded_thread_count = 4;
+static constexpr size_t s_threaded_passes = s_threaded_thread_count * 32;
+
+// layers of the same parity share scratch between checkpoints and outside of training. these
+// widen from one to the next, so that a block of passes writing a wide layer would overrun the
+// narrow one another block is still reading if their scratch were laid out by layer width alone
+static std::unique_ptr<neuralnet::network> create_threaded_network() {
+    std::vector<neuralnet::layer_spec_t> specs(4);
+    specs[0] = { 4, activation_function::sigmoid };
+    specs[1] = { 4, activation_function::tanh };
+    specs[2] = { 256, activation_function::gelu };
+    specs[3] = { 3, activation_function::softmax };
+
+    return randomize_network(8, specs, false);
+}
+
+// a third of the batches are a single pass
+static size_t get_random_passes() {
+    return neuralnet::random::next<size_t>(0, 3) == 0 ? 1 : neuralnet::random::next<size_t>(2, 96);
+}
+
+// half of the inputs are zero. softmax outputs are trained against one-hot vectors
+static batch_t create_batch(const neuralnet::network* nn, size_t passes) {
+    const auto& layers = nn->get_layers();
+    uint64_t input_count = layers.front().previous_size;
+    uint64_t output_count = layers.back().size;
+
+    batch_t batch;
+    batch.passes = passes;
+
+    batch.inputs = random_values(batch.passes * input_count, -1, 1);
+    for (auto& input : batch.inputs) {
+        if (neuralnet::random::next<size_t>(0, 1) == 0) {
+            input = 0;
+        }
+    }
+
+    if (layers.back().function == activation_function::softmax) {
+        batch.expected_outputs.assign(batch.passes * output_count, 0);
+
+        for (size_t pass = 0; pass < batch.passes; pass++) {
+            uint64_t label = neuralnet::random::next<uint64_t>(0, output_count - 1);
+            batch.expected_outputs[pass * output_count + label] = 1;
+        }
+    } else {
+        batch.expected_outputs = random_values(batch.passes * output_count, 0, 1);
+    }
+
+    return batch;
+}
+
+// makes every weight exactly representable in format, so that evaluations reading the weights in
+// it see the same network as the reference
+static void round_weights(neuralnet::network* nn, parameter_format format) {
+    std::vector<uint16_t> reduced;
+
+    for (auto& layer : nn->get_layers()) {
+        size_t count = layer.weights.size();
+        reduced.resize(count);
+
+        neuralnet::reduce_parameters(layer.weights.data(), reduced.data(), count, format);
+        neuralnet::widen_parameters(reduced.data(), layer.weights.data(), count, format);
+    }
+}
+
+static void describe_trial(const std::string& name, const neuralnet::network* nn,
+                           const batch_t& batch) {
+    const auto& layers = nn->get_layers();
+
+    std::cout << name << ": " << layers.front().previous_size << " inputs";
+    for (const auto& layer : layers) {
+        std::cout << ", " << layer.size << " " << get_function_name(layer.function);
+    }
+
+    std::cout << ", " << batch.passes << " passes" << std::endl;
+}
+
+// returns false if any check is past its tolerance
+static bool report() {
+    size_t width = 0;
+    for (const auto& check : s_checks) {
+        width = std::max(width, check.name.size());
+    }
+
+    size_t failures = 0;
+    for (const auto& check : s_checks) {
+        // nan compares false, and fails
+        bool passed = check.error.relative <= check.tolerance;
+        if (!passed) {
+            failures++;
+        }
+
+        std::cout << std::left << std::setw((int)width) << check.name << std::right
+                  << "  max ulp " << std::setw(20) << check.error.ulp << "  max rel "
+                  << std::scientific << std::setprecision(2) << check.error.relative
+                  << " (tolerance " << check.tolerance << ")  " << (passed ? "ok" : "FAIL")
+                  << '\n';
+    }
+
+    std::cout << s_checks.size() - failures << " of " << s_checks.size()
+              << " checks within tolerance" << std::endl;
+
+    return failures == 0;
+}
+
+int main(int argc, const char** argv) {
+    size_t trials = argc > 1 ? std::stoull(argv[1]) : 8;
+    uint64_t seed = argc > 2 ? std::stoull(argv[2]) : 1;
+
+    // fixed by default, so that runs are comparable
+    neuralnet::random::rng().seed(seed);
+
+    for (auto isa : s_isas) {
+        auto kernels = evaluators::get_cpu_kernels<number_t>(isa);
+        if (kernels == nullptr) {
+            std::cout << "skipping " << evaluators::get_cpu_isa_name(isa)
+                      << " kernels: not supported by this host or build" << std::endl;
+
+            continue;
+        }
+
+        check_kernels(*kernels);
+    }
+
+#ifdef NN_SUPPORT_cpu
+    evaluators::cpu_evaluator cpu_evaluator;
+    evaluators::basic_cpu_evaluator<double> double_evaluator;
+#endif
+
+    for (size_t trial = 0; trial < trials; trial++) {
+        auto base = create_network(trial % 2 == 1);
+        auto batch = create_batch(base.get(), get_random_passes());
+        describe_trial("trial " + std::to_string(trial), base.get(), batch);
+
+        for (auto format : s_formats) {
+            auto nn = neuralnet::unique(neuralnet::network::convert(base.get()));
+            if (format != parameter_format::fp32) {
+                round_weights(nn.get(), format);
+            }
+
+            using double_network = neuralnet::basic_network<double>;
+            auto reference_network = neuralnet::unique(double_network::convert(nn.get()));
+
+            reference_t reference;
+            evaluate_reference(reference_network.get(), batch, &reference);
+
+            if (format == parameter_format::fp32) {
+                check_reference_gradient(reference_network.get(), batch, reference);
+            }
+
+#ifdef NN_SUPPORT_cpu
+            check_cpu_evaluator(cpu_evaluator, "cpu f32", nn.get(), format, batch, reference);
+            check_cpu_evaluator(double_evaluator, "cpu f64", reference_network.get(), format,
+                                batch, reference);
+
+            // both networks are about to be freed, and their addresses may be reused
+            cpu_evaluator.invalidate_weights(nn.get());
+            double_evaluator.invalidate_weights(reference_network.get());
+#endif
+
+#ifdef NN_SUPPORT_vulkan
+            check_vulkan_evaluator(nn.get(), format, batch, reference);
+#endif
+        }
+    }
+
+#ifdef NN_SUPPORT_cpu
+    // random trials are often too small to split passes across threads, and the host may have
+    // only a few. this one always runs several blocks of passes per thread of its own pool
+    {
+        auto nn = create_threaded_network();
+        auto batch = create_batch(nn.get(), s_threaded_passes);
+        describe_trial("threaded trial", nn.get(), batch);
+
+        using double_network = neuralnet::basic_network<double>;
+        auto reference_network = neuralnet::unique(double_network::convert(nn.get()));
+
+        reference_t reference;
+        evaluate_reference(reference_network.get(), batch, &reference);
+
+        evaluators::cpu_evaluator threaded_evaluator(s_threaded_thread_count);
+        evaluators::basic_cpu_evaluator<double> threaded_double_evaluator(
+            s_threaded_thread_count);
+
+        check_cpu_evaluator(threaded_evaluator, "cpu f32 threaded", nn.get(),
+                            parameter_format::fp32, batch, reference);
+        check_cpu_evaluator(threaded_double_evaluator, "cpu f64 threaded",
+                            reference_network.get(), parameter_format::fp32, batch, reference);
+    }
+#endif
+
+    return report() ? 0 : 1;
+}
\ No newline at end of file
@@ -0,0 +1,241 @@
+// compiles a saved network (network.json + N.dat) into a standalone c++ translation unit
+// the output has its parameters as constexpr arrays and one function per layer, with every size
+// baked in. it only includes <cmath> and <cstddef>, so it links without neuralnet, zlib or json
+//
+// usage: nn_network_exporter <network directory> <output .cpp> [namespace]
+
+#include <neuralnet.h>
+
+#include <charconv>
+#include <iostream>
+#include <sstream>
+
+// inputs are accumulated four at a time, see static_network
+static constexpr uint64_t s_input_group = 4;
+
+static std::string format_number(neuralnet::number_t value) {
+    if (!std::isfinite(value)) {
+        throw std::runtime_error("network has non-finite parameters!");
+    }
+
+    // shortest representation that reads back as the same float
+    char buffer[64];
+    auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    if (result.ec != std::errc()) {
+        throw std::runtime_error("failed to format parameter!");
+    }
+
+    std::string text(buffer, result.ptr);
+    if (text.find_first_of(".e") == std::string::npos) {
+        text += ".0";
+    }
+
+    return text + "f";
+}
+
+// writes values as the body of an array initializer, a few to a line
+static void write_numbers(std::ostream& stream, const neuralnet::number_t* values, size_t count) {
+    static constexpr size_t per_line = 6;
+
+    for (size_t i = 0; i < count; i++) {
+        if (i % per_line == 0) {
+            stream << (i > 0 ? ",\n" : "") << "        ";
+        } else {
+            stream << ", ";
+        }
+
+        stream << format_number(values[i]);
+    }
+
+    stream << '\n';
+}
+
+// expression applying a layer's activation function to z[c], see neuralnet::activate
+static std::string get_activation(neuralnet::activation_function function) {
+    switch (function) {
+    case neuralnet::activation_function::sigmoid:
+        return "1.0f / (1.0f + std::exp(-z[c]))";
+    case neuralnet::activation_function::relu:
+        return "z[c] > 0.0f ? z[c] : 0.0f";
+    case neuralnet::activation_function::leaky_relu:
+        return "z[c] > 0.0f ? z[c] : z[c] * " + format_number(neuralnet::leaky_relu_slope);
+    case neuralnet::activation_function::tanh:
+        return "std::tanh(z[c])";
+    case neuralnet::activation_function::gelu: {
+        auto scale = format_number((neuralnet::number_t)-neuralnet::gelu_scale);
+        auto cubic = format_number((neuralnet::number_t)neuralnet::gelu_cubic);
+
+        return "z[c] / (1.0f + std::exp(" + scale + " * (z[c] + " + cubic +
+               " * z[c] * z[c] * z[c])))";
+    }
+    case neuralnet::activation_function::identity:
+        return "z[c]";
+    default:
+        throw std::runtime_error("invalid activation function!");
+    }
+}
+
+static void write_layer(std::ostream& stream, const neuralnet::layer_t& layer, size_t index) {
+    uint64_t size = layer.size;
+    uint64_t previous_size = layer.previous_size;
+
+    // transposed (previous_size x size), so that every input adds a contiguous row
+    std::vector<neuralnet::number_t> transposed(layer.weights.size());
+    for (uint64_t c = 0; c < size; c++) {
+        for (uint64_t p = 0; p < previous_size; p++) {
+            transposed[p * size + c] = layer.weights[c * previous_size + p];
+        }
+    }
+
+    stream << "    alignas(64) constexpr float layer" << index << "_biases[" << size << "] = {\n";
+    write_numbers(stream, layer.biases.data(), layer.biases.size());
+    stream << "    };\n\n";
+
+    stream << "    alignas(64) constexpr float layer" << index << "_weights[" << previous_size
+           << " * " << size << "] = {\n";
+
+    write_numbers(stream, transposed.data(), transposed.size());
+    stream << "    };\n\n";
+
+    uint64_t grouped_size = previous_size - previous_size % s_input_group;
+    std::string prefix = "layer" + std::to_string(index);
+
+    stream << "    static void " << prefix << "(const float* inputs, float* outputs) {\n";
+    stream << "        float z[" << size << "];\n";
+    stream << "        for (size_t c = 0; c < " << size << "; c++) {\n";
+    stream << "            z[c] = " << prefix << "_biases[c];\n";
+    stream << "        }\n\n";
+
+    if (grouped_size > 0) {
+        stream << "        for (size_t p = 0; p < " << grouped_size << "; p += 4) {\n";
+        stream << "            const float* rows = &" << prefix << "_weights[p * " << size
+               << "];\n";
+        stream << "            for (size_t c = 0; c < " << size << "; c++) {\n";
+        stream << "                z[c] += inputs[p] * rows[c] + inputs[p + 1] * rows[" << size
+               << " + c] +\n";
+        stream << "                        inputs[p + 2] * rows[" << size * 2
+               << " + c] + inputs[p + 3] * rows[" << size * 3 << " + c];\n";
+        stream << "            }\n";
+        stream << "        }\n\n";
+    }
+
+    if (grouped_size < previous_size) {
+        stream << "        for (size_t p = " << grouped_size << "; p < " << previous_size
+               << "; p++) {\n";
+        stream << "            const float* row = &" << prefix << "_weights[p * " << size
+               << "];\n";
+        stream << "            for (size_t c = 0; c < " << size << "; c++) {\n";
+        stream << "                z[c] += inputs[p] * row[c];\n";
+        stream << "            }\n";
+        stream << "        }\n\n";
+    }
+
+    // softmax normalizes over the whole layer, shifted by the largest z
+    if (layer.function == neuralnet::activation_function::softmax) {
+        stream << "        float maximum = z[0];\n";
+        stream << "        for (size_t c = 1; c < " << size << "; c++) {\n";
+        stream << "            maximum = z[c] > maximum ? z[c] : maximum;\n";
+        stream << "        }\n\n";
+        stream << "        float sum = 0.0f;\n";
+        stream << "        for (size_t c = 0; c < " << size << "; c++) {\n";
+        stream << "            outputs[c] = std::exp(z[c] - maximum);\n";
+        stream << "            sum += outputs[c];\n";
+        stream << "        }\n\n";
+        stream << "        for (size_t c = 0; c < " << size << "; c++) {\n";
+        stream << "            outputs[c] /= sum;\n";
+        stream << "        }\n";
+    } else {
+        stream << "        for (size_t c = 0; c < " << size << "; c++) {\n";
+        stream << "            outputs[c] = " << get_activation(layer.function) << ";\n";
+        stream << "        }\n";
+    }
+
+    stream << "    }\n\n";
+}
+
+static void write_network(std::ostream& stream, const neuralnet::network* nn,
+                          const std::string& source, const std::string& name) {
+    const auto& layers = nn->get_layers();
+
+    uint64_t input_count = layers[0].previous_size;
+    uint64_t output_count = layers[layers.size() - 1].size;
+
+    uint64_t width = 1;
+    for (size_t i = 0; i + 1 < layers.size(); i++) {
+        width = std::max(width, layers[i].size);
+    }
+
+    stream << "// generated by nn_network_exporter from " << source << ". do not edit\n";
+    stream << "// callers declare " << name << "::eval(const float* inputs, float* outputs)\n\n";
+    stream << "#include <cmath>\n";
+    stream << "#include <cstddef>\n\n";
+    stream << "namespace " << name << " {\n";
+    stream << "    inline constexpr size_t input_count = " << input_count << ";\n";
+    stream << "    inline constexpr size_t output_count = " << output_count << ";\n\n";
+
+    for (size_t i = 0; i < layers.size(); i++) {
+        write_layer(stream, layers[i], i);
+    }
+
+    // hidden layers ping-pong between two stack buffers. a single layer writes straight to the
+    // outputs, and declaring them anyway would warn in the generated file
+    stream << "    void eval(const float* inputs, float* outputs) {\n";
+    if (layers.size() > 1) {
+        stream << "        float scratch[2][" << width << "];\n";
+    }
+
+    for (size_t i = 0; i < layers.size(); i++) {
+        std::string src = i > 0 ? "scratch[" + std::to_string((i - 1) % 2) + "]" : "inputs";
+        std::string dst =
+            i + 1 < layers.size() ? "scratch[" + std::to_string(i % 2) + "]" : "outputs";
+
+        stream << "        layer" << i << "(" << src << ", " << dst << ");\n";
+    }
+
+    stream << "    }\n";
+    stream << "} // namespace " << name << '\n';
+}
+
+int main(int argc, const char** argv) {
+    if (argc < 3) {
+        std::cerr << "usage: " << argv[0] << " <network directory> <output .cpp> [namespace]"
+                  << std::endl;
+
+        return 1;
+    }
+
+    neuralnet::fs::path directory = argv[1];
+    neuralnet::fs::path output_path = argv[2];
+    std::string name = argc > 3 ? argv[3] : "exported_network";
+
+    neuralnet::loader loader(directory);
+    if (!loader.load_from_file()) {
+        std::cerr << "failed to load network from " << directory << std::endl;
+        return 1;
+    }
+
+    auto network = neuralnet::unique(loader.release_network());
+    if (network->get_layers().empty()) {
+        std::cerr << "network has no layers" << std::endl;
+        return 1;
+    }
+
+    auto output_directory = output_path.parent_path();
+    if (!output_directory.empty() && !neuralnet::fs::is_directory(output_directory)) {
+        neuralnet::fs::create_directories(output_directory);
+    }
+
+    std::stringstream source;
+    write_network(source, network.get(), directory.string(), name);
+
+    std::ofstream file(output_path);
+    if (!file.is_open()) {
+        std::cerr << "could not open " << output_path << std::endl;
+        return 1;
+    }
+
+    file << source.str();
+    std::cout << "wrote " << output_path << std::endl;
+
+    return 0;
+}
\ No newline at end of file